@@ -0,0 +1,109 @@
+/*
+    Copyright (C) 2025 by Michael Kristofik <kristo605@gmail.com>
+    Part of the Champions of Anduran project.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    or at your option any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY.
+
+    See the COPYING.txt file for more details.
+*/
+#include "bench_utils.h"
+
+#include "RandomRange.h"
+#include "hex_utils.h"
+
+#include <algorithm>
+#include <format>
+#include <iostream>
+#include <vector>
+
+namespace
+{
+    HexArray random_hexes(int count, int width)
+    {
+        RandomRange randCoord(0, width - 1);
+        HexArray hexes;
+        for (int i = 0; i < count; ++i) {
+            hexes.x.push_back(randCoord.get());
+            hexes.y.push_back(randCoord.get());
+        }
+        return hexes;
+    }
+}
+
+
+// Compare measuring distances one hex at a time vs. in batches.
+BENCHMARK(hex_distance)
+{
+    const int width = 1024;
+    const Hex src(width / 2, width / 2 + 1);
+    const char *kernel = hexDistanceKernel();
+
+    for (int count : {1'000, 1'000'000}) {
+        const auto hexes = random_hexes(count, width);
+        const int reps = 1'000'000 / count;
+
+        std::vector<int> eachHex(count);
+        double eachMs = bench_median_ms([&] {
+            for (int r = 0; r < reps; ++r) {
+                for (int i = 0; i < count; ++i) {
+                    eachHex[i] = hexDistance(src, hexes[i]);
+                }
+                bench_keep(eachHex);
+            }
+        });
+
+        std::vector<int> batch(count);
+        double batchMs = bench_median_ms([&] {
+            for (int r = 0; r < reps; ++r) {
+                hexDistances(src, hexes, batch);
+                bench_keep(batch);
+            }
+        });
+
+        const auto label = std::format("{} hexes x{}", count, reps);
+        bench_report("hexDistance", label, eachMs);
+        bench_report(std::format("hexDistances ({})", kernel), label, batchMs);
+        if (batch != eachHex) {
+            std::cout << "ERROR: distances don't match\n";
+        }
+    }
+}
+
+// Assign hexes to the nearest of a few centers, like hexClusters() does.
+BENCHMARK(hex_closest_centers)
+{
+    const int width = 256;
+    const char *kernel = hexDistanceKernel();
+    const auto hexes = random_hexes(100'000, width);
+
+    for (int numCenters : {4, 16}) {
+        const auto centerArray = random_hexes(numCenters, width);
+        std::vector<Hex> centers;
+        for (int c = 0; c < numCenters; ++c) {
+            centers.push_back(centerArray[c]);
+        }
+
+        std::vector<int> eachHex(hexes.size());
+        double eachMs = bench_median_ms([&] {
+            for (int i = 0; i < hexes.size(); ++i) {
+                eachHex[i] = hexClosestIdx(hexes[i], centers);
+            }
+        });
+
+        std::vector<int> batch;
+        double batchMs = bench_median_ms([&] {
+            batch = hexClosestIdx(hexes, centers);
+        });
+
+        const auto label = std::format("{} hexes, {} centers", hexes.size(), numCenters);
+        bench_report("hexClosestIdx", label, eachMs);
+        bench_report(std::format("hexClosestIdx batch ({})", kernel), label, batchMs);
+        if (batch != eachHex) {
+            std::cout << "ERROR: closest centers don't match\n";
+        }
+    }
+}
@@ -0,0 +1,60 @@
+/*
+    Copyright (C) 2025 by Michael Kristofik <kristo605@gmail.com>
+    Part of the Champions of Anduran project.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    or at your option any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY.
+
+    See the COPYING.txt file for more details.
+*/
+#include "bench_utils.h"
+
+#include <cstdlib>
+#include <format>
+#include <iostream>
+#include <string_view>
+#include <utility>
+
+namespace
+{
+    // Function-local static avoids depending on the order that global
+    // registration variables get initialized across files.
+    std::vector<std::pair<std::string, BenchFunc>> & registry()
+    {
+        static std::vector<std::pair<std::string, BenchFunc>> benchmarks;
+        return benchmarks;
+    }
+}
+
+
+int bench_register(const char *name, BenchFunc func)
+{
+    registry().emplace_back(name, func);
+    return ssize(registry());
+}
+
+void bench_report(const std::string &name, const std::string &label, double ms)
+{
+    std::cout << std::format("{:<24} {:<28} {:>10.3f} ms\n", name, label, ms);
+}
+
+
+int main(int argc, char *argv[])
+{
+    std::string_view filter;
+    if (argc >= 2) {
+        filter = argv[1];
+    }
+
+    std::ranges::sort(registry(), {}, [] (auto &elem) { return elem.first; });
+    for (auto &[name, func] : registry()) {
+        if (name.find(filter) != std::string::npos) {
+            func();
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,76 @@
+/*
+    Copyright (C) 2025 by Michael Kristofik <kristo605@gmail.com>
+    Part of the Champions of Anduran project.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    or at your option any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY.
+
+    See the COPYING.txt file for more details.
+*/
+#include "bench_utils.h"
+
+#include "open-simplex-noise.h"
+#include "thread_utils.h"
+
+#include <algorithm>
+#include <format>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    // Same scale RandomMap uses for obstacles.
+    const double NOISE_FEATURE_SIZE = 2.0;
+}
+
+
+// Compare filling a noise field one point at a time vs. in batches.
+BENCHMARK(noise_field)
+{
+    osn_context *tmp = nullptr;
+    open_simplex_noise(12345, &tmp);
+    std::shared_ptr<osn_context> ctx(tmp, open_simplex_noise_free);
+
+    for (int width : {256, 1024}) {
+        const int size = width * width;
+
+        std::vector<double> eachPoint(size);
+        double eachMs = bench_median_ms([&] {
+            for (int i = 0; i < size; ++i) {
+                eachPoint[i] = open_simplex_noise2(ctx.get(),
+                                                   i % width / NOISE_FEATURE_SIZE,
+                                                   i / width / NOISE_FEATURE_SIZE);
+            }
+        });
+
+        std::vector<double> grid(size);
+        double gridMs = bench_median_ms([&] {
+            open_simplex_noise2_grid(ctx.get(), 0, 0, width, width,
+                                     NOISE_FEATURE_SIZE, grid.data());
+        });
+
+        const int numThreads = std::max<int>(std::thread::hardware_concurrency(), 2);
+        std::vector<double> threaded(size);
+        double threadedMs = bench_median_ms([&] {
+            parallel_blocks(width, numThreads, [&] (int yBegin, int yEnd, int) {
+                open_simplex_noise2_grid(ctx.get(), 0, yBegin, width, yEnd - yBegin,
+                                         NOISE_FEATURE_SIZE,
+                                         threaded.data() + yBegin * width);
+            });
+        });
+
+        bench_report("open_simplex_noise2", std::format("width {}", width), eachMs);
+        bench_report("open_simplex_noise2_grid", std::format("width {}", width), gridMs);
+        bench_report("open_simplex_noise2_grid",
+                     std::format("width {}, {} threads", width, numThreads),
+                     threadedMs);
+        if (grid != eachPoint || threaded != eachPoint) {
+            std::cout << "ERROR: noise values don't match\n";
+        }
+    }
+}
@@ -0,0 +1,100 @@
+/*
+    Copyright (C) 2025 by Michael Kristofik <kristo605@gmail.com>
+    Part of the Champions of Anduran project.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    or at your option any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY.
+
+    See the COPYING.txt file for more details.
+*/
+#include "bench_utils.h"
+
+#include "PriorityQueue.h"
+#include "RandomRange.h"
+
+#include <format>
+#include <iostream>
+#include <vector>
+
+namespace
+{
+    struct QueueElem
+    {
+        int index = 0;
+        int cost = 0;
+
+        bool operator>(const QueueElem &rhs) const { return cost > rhs.cost; }
+    };
+
+    // Mimic an A* search: pop the cheapest element, then push a few neighbors
+    // costing the same or a little more.  Return a checksum of the pops.
+    template <typename Queue>
+    long long search_like(Queue &q, const std::vector<int> &steps, int numPops)
+    {
+        q.clear();
+        q.push({0, 0});
+        long long checksum = 0;
+        int s = 0;
+        for (int i = 0; i < numPops && !q.empty(); ++i) {
+            const auto elem = q.pop();
+            checksum += elem.cost;
+            for (int n = 0; n < 3; ++n) {
+                q.push({elem.index + n, elem.cost + steps[s]});
+                s = (s + 1) % ssize(steps);
+            }
+        }
+        return checksum;
+    }
+}
+
+
+// Compare the lazy heap Pathfinder used to use with the queues meant for
+// interleaved pushes and pops.
+BENCHMARK(priority_queue)
+{
+    RandomRange randStep(0, 2);
+    std::vector<int> steps(1000);
+    for (auto &step : steps) {
+        step = randStep.get();
+    }
+
+    for (int numPops : {100, 10'000}) {
+        const int reps = 100'000 / numPops;
+        std::vector<long long> checksums;
+
+        PriorityQueue<QueueElem> lazy;
+        double lazyMs = bench_median_ms([&] {
+            for (int r = 0; r < reps; ++r) {
+                bench_keep(search_like(lazy, steps, numPops));
+            }
+        });
+        checksums.push_back(search_like(lazy, steps, numPops));
+
+        BinaryHeap<QueueElem> heap;
+        double heapMs = bench_median_ms([&] {
+            for (int r = 0; r < reps; ++r) {
+                bench_keep(search_like(heap, steps, numPops));
+            }
+        });
+        checksums.push_back(search_like(heap, steps, numPops));
+
+        BucketQueue<QueueElem> buckets;
+        double bucketMs = bench_median_ms([&] {
+            for (int r = 0; r < reps; ++r) {
+                bench_keep(search_like(buckets, steps, numPops));
+            }
+        });
+        checksums.push_back(search_like(buckets, steps, numPops));
+
+        const auto label = std::format("{} pops x{}", numPops, reps);
+        bench_report("PriorityQueue (lazy)", label, lazyMs);
+        bench_report("BinaryHeap", label, heapMs);
+        bench_report("BucketQueue", label, bucketMs);
+        if (checksums[1] != checksums[0] || checksums[2] != checksums[0]) {
+            std::cout << "ERROR: queues popped different costs\n";
+        }
+    }
+}
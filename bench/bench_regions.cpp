@@ -0,0 +1,76 @@
+/*
+    Copyright (C) 2025 by Michael Kristofik <kristo605@gmail.com>
+    Part of the Champions of Anduran project.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    or at your option any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY.
+
+    See the COPYING.txt file for more details.
+*/
+#include "bench_utils.h"
+
+#include "RandomRange.h"
+#include "hex_utils.h"
+
+#include <algorithm>
+#include <format>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    // Same density RandomMap uses.
+    const int REGION_SIZE = 64;
+
+    std::vector<Hex> random_centers(int width)
+    {
+        RandomRange randCoord(0, width - 1);
+        std::vector<Hex> centers(width * width / REGION_SIZE);
+        std::ranges::generate(centers, [&randCoord] {
+            return Hex{randCoord.get(), randCoord.get()};
+        });
+        return centers;
+    }
+}
+
+
+// Compare assigning every tile to its nearest region center one at a time vs.
+// all at once.
+BENCHMARK(region_assignment)
+{
+    for (int width : {72, 144, 288}) {
+        const int size = width * width;
+        const auto centers = random_centers(width);
+
+        std::vector<int> eachTile(size);
+        double eachMs = bench_median_ms([&] {
+            for (int i = 0; i < size; ++i) {
+                eachTile[i] = hexClosestIdx(Hex(i % width, i / width), centers);
+            }
+        }, 1);
+
+        std::vector<int> grid;
+        double gridMs = bench_median_ms([&] {
+            grid = hexClosestIdxGrid(width, centers);
+        });
+
+        const int numThreads = std::max<int>(std::thread::hardware_concurrency(), 2);
+        std::vector<int> threaded;
+        double threadedMs = bench_median_ms([&] {
+            threaded = hexClosestIdxGrid(width, centers, numThreads);
+        });
+
+        bench_report("hexClosestIdx", std::format("width {}", width), eachMs);
+        bench_report("hexClosestIdxGrid", std::format("width {}", width), gridMs);
+        bench_report("hexClosestIdxGrid",
+                     std::format("width {}, {} threads", width, numThreads),
+                     threadedMs);
+        if (grid != eachTile || threaded != eachTile) {
+            std::cout << "ERROR: region assignments don't match\n";
+        }
+    }
+}
@@ -0,0 +1,70 @@
+/*
+    Copyright (C) 2025 by Michael Kristofik <kristo605@gmail.com>
+    Part of the Champions of Anduran project.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    or at your option any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY.
+
+    See the COPYING.txt file for more details.
+*/
+#ifndef BENCH_UTILS_H
+#define BENCH_UTILS_H
+
+#include <algorithm>
+#include <chrono>
+#include <concepts>
+#include <string>
+#include <vector>
+
+// Bare-bones microbenchmark harness.  Each bench_*.cpp file registers its
+// benchmarks with the BENCHMARK macro, and the microbench executable runs all
+// of them (or just the ones whose names contain the first command-line
+// argument).
+//
+// Example usage:
+//     BENCHMARK(my_algorithm)
+//     {
+//         double ms = bench_median_ms([] { ... });
+//         bench_report("my_algorithm", "width 144", ms);
+//     }
+using BenchFunc = void (*)();
+int bench_register(const char *name, BenchFunc func);
+
+#define BENCHMARK(name) \
+    static void name(); \
+    [[maybe_unused]] static const int name##_registered = bench_register(#name, name); \
+    static void name()
+
+// Print one result line in a format that's easy to grep and diff.
+void bench_report(const std::string &name, const std::string &label, double ms);
+
+// Keep the compiler from optimizing away a result we never look at.
+template <typename T>
+void bench_keep(const T &value)
+{
+    asm volatile("" : : "g"(&value) : "memory");
+}
+
+// Run the function several times, return the median time of one run in
+// milliseconds.
+template <std::invocable F>
+double bench_median_ms(F &&func, int reps = 5)
+{
+    using clock = std::chrono::steady_clock;
+
+    std::vector<double> times;
+    for (int i = 0; i < reps; ++i) {
+        auto start = clock::now();
+        func();
+        std::chrono::duration<double, std::milli> elapsed = clock::now() - start;
+        times.push_back(elapsed.count());
+    }
+
+    std::ranges::nth_element(times, begin(times) + reps / 2);
+    return times[reps / 2];
+}
+
+#endif
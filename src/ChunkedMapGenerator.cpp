@@ -0,0 +1,677 @@
+/*
+    Copyright (C) 2025 by Michael Kristofik <kristo605@gmail.com>
+    Part of the Champions of Anduran project.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    or at your option any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY.
+
+    See the COPYING.txt file for more details.
+*/
+#include "ChunkedMapGenerator.h"
+#include "DisjointSets.h"
+#include "ObjectManager.h"
+#include "RandomMap.h"
+#include "RandomRange.h"
+#include "TileBitset.h"
+#include "binary_utils.h"
+#include "json_utils.h"
+#include "map_file_format.h"
+#include "thread_utils.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <deque>
+#include <filesystem>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+
+namespace
+{
+    // One region per cell, same average size as RandomMap.
+    const int CELL_SIZE = 8;
+    static_assert(CELL_SIZE * CELL_SIZE == RandomMap::regionSize);
+
+    // Every tile is closer to its own cell's center (at most 14 tiles away) than
+    // that, so it's also within this distance of its region's center.
+    const int REGION_REACH = 2 * CELL_SIZE;
+
+    // Extra rows on each side of a band, enough to see in full every region
+    // touching the band and every region bordering one of those.  That's all
+    // it takes to decide which obstacles to clear in the band.
+    const int MARGIN_ROWS = 4 * REGION_REACH + 2;
+
+    // Independent random streams derived from the map seed.  Obstacles use the
+    // same noise as RandomMap.
+    enum SeedStream : unsigned int
+    {
+        obstacleStream,
+        centerStream,
+        altitudeStream,
+        terrainStream,
+        castleStream
+    };
+
+    // Hash to a number from a stream, for things that have to come out the same
+    // no matter which band asks.
+    unsigned int stream_value(unsigned int seed, SeedStream stream, unsigned int index)
+    {
+        return RandomRange::split_seed(RandomRange::split_seed(seed, stream), index);
+    }
+
+    TileBitset slice_bits(const TileBitset &bits, int begin, int count)
+    {
+        TileBitset slice(count);
+        for (int i = 0; i < count; ++i) {
+            if (bits[begin + i]) {
+                slice.set(i);
+            }
+        }
+        return slice;
+    }
+
+    void write_ints(JsonArrayWriter &json, const char *name, std::span<const int> values)
+    {
+        json.startArray(name);
+        for (int v : values) {
+            json.push(v);
+        }
+        json.endArray();
+    }
+
+    void write_bits(JsonArrayWriter &json,
+                    const char *name,
+                    std::span<const uint64_t> words,
+                    int64_t size)
+    {
+        json.startArray(name);
+        for (int64_t i = 0; i < size; ++i) {
+            json.push((words[i / 64] >> (i % 64)) & 1);
+        }
+        json.endArray();
+    }
+}
+
+
+ChunkedMapGenerator::ChunkedMapGenerator(int width,
+                                         unsigned int seed,
+                                         int bandRows,
+                                         int numThreads)
+    : width_(width),
+    seed_(seed),
+    bandRows_(std::clamp(bandRows, 1, width)),
+    numThreads_(std::max(numThreads, 1)),
+    cellsPerRow_((width + CELL_SIZE - 1) / CELL_SIZE),
+    altitudeNoise_(RandomRange::split_seed(seed, altitudeStream)),
+    obstacleNoise_(RandomRange::split_seed(seed, obstacleStream)),
+    regionCenters_(),
+    regionTerrain_(),
+    castles_()
+{
+    assert(width_ > 0);
+
+    // Every band but the last has to fill whole words of the packed bitsets.
+    const int rowsPerWord = 64 / std::gcd(width_, 64);
+    bandRows_ = (bandRows_ + rowsPerWord - 1) / rowsPerWord * rowsPerWord;
+
+    // One region center at a random spot in each cell.  Cells along the right
+    // and bottom edges might be cut short.
+    for (int cy = 0; cy < cellsPerRow_; ++cy) {
+        for (int cx = 0; cx < cellsPerRow_; ++cx) {
+            const auto h = stream_value(seed_, centerStream, regionCenters_.size());
+            const int cellWidth = std::min(CELL_SIZE, width_ - cx * CELL_SIZE);
+            const int cellHeight = std::min(CELL_SIZE, width_ - cy * CELL_SIZE);
+            regionCenters_.emplace_back(cx * CELL_SIZE + h % cellWidth,
+                                        cy * CELL_SIZE + (h / CELL_SIZE) % cellHeight);
+        }
+    }
+
+    for (int r = 0; r < numRegions(); ++r) {
+        regionTerrain_.push_back(terrainAt(r));
+    }
+
+    placeCastles();
+}
+
+void ChunkedMapGenerator::writeBinaryFile(const char *filename) const
+{
+    using Writer = BinaryStreamWriter;
+
+    const int64_t size = static_cast<int64_t>(width_) * width_;
+    const int64_t numWords = (size + 63) / 64;
+    const int numObjectOffsets = enum_size<ObjectType>() + 1;
+    const Writer::SectionSize sections[] = {
+        Writer::sectionSize<int>(MapFile::tileRegions, size),
+        Writer::sectionSize<int>(MapFile::regionTerrain, numRegions()),
+        Writer::sectionSize<uint64_t>(MapFile::tileObstacles, numWords),
+        Writer::sectionSize<uint64_t>(MapFile::tileOccupied, numWords),
+        Writer::sectionSize<uint64_t>(MapFile::tileWalkable, numWords),
+        Writer::sectionSize<int>(MapFile::castles, castles_.size()),
+        Writer::sectionSize<int>(MapFile::regionCastleDistance, numRegions()),
+        Writer::sectionSize<int>(MapFile::objectOffsets, numObjectOffsets),
+        Writer::sectionSize<int>(MapFile::objectTiles, 0)
+    };
+    Writer file(filename, MapFile::magic, MapFile::version, sections);
+
+    std::vector<int> terrain;
+    std::ranges::transform(regionTerrain_, std::back_inserter(terrain),
+                           [] (Terrain t) { return static_cast<int>(t); });
+    file.append(MapFile::regionTerrain, std::span<const int>(terrain));
+
+    std::vector<int> castleTiles;
+    for (auto &hex : castles_) {
+        castleTiles.push_back(hex.y * width_ + hex.x);
+    }
+    file.append(MapFile::castles, std::span<const int>(castleTiles));
+
+    const std::vector<int> objOffsets(numObjectOffsets, 0);
+    file.append(MapFile::objectOffsets, std::span<const int>(objOffsets));
+
+    std::vector<std::pair<int, int>> regionPairs;
+    for (int y = 0; y < width_; y += bandRows_) {
+        writeBand(y, std::min(y + bandRows_, width_), file, regionPairs);
+    }
+
+    const auto castleDist = regionCastleDistance(regionPairs);
+    file.append(MapFile::regionCastleDistance, std::span<const int>(castleDist));
+    file.finish();
+}
+
+void ChunkedMapGenerator::writeJsonFile(const char *filename) const
+{
+    const auto binFile = std::string(filename) + ".tmp";
+    writeBinaryFile(binFile.c_str());
+
+    try {
+        const int64_t size = static_cast<int64_t>(width_) * width_;
+        BinaryFileReader bin(binFile.c_str(), MapFile::magic, MapFile::version);
+        JsonArrayWriter json(filename);
+
+        // Same arrays, in the same order, as RandomMap::writeFile().
+        write_ints(json, "tile-regions", bin.section<int>(MapFile::tileRegions));
+        write_ints(json, "region-terrain", bin.section<int>(MapFile::regionTerrain));
+        write_bits(json, "tile-obstacles", bin.section<uint64_t>(MapFile::tileObstacles), size);
+        write_bits(json, "tile-occupied", bin.section<uint64_t>(MapFile::tileOccupied), size);
+        write_bits(json, "tile-walkable", bin.section<uint64_t>(MapFile::tileWalkable), size);
+        write_ints(json, "castles", bin.section<int>(MapFile::castles));
+        write_ints(json, "region-castle-distance",
+                   bin.section<int>(MapFile::regionCastleDistance));
+        json.startObject("objects");
+        json.endObject();
+        json.finish();
+    }
+    catch (const std::runtime_error &) {
+        std::filesystem::remove(binFile);
+        throw;
+    }
+
+    std::filesystem::remove(binFile);
+}
+
+int ChunkedMapGenerator::width() const
+{
+    return width_;
+}
+
+int ChunkedMapGenerator::numRegions() const
+{
+    return ssize(regionCenters_);
+}
+
+int ChunkedMapGenerator::bandRows() const
+{
+    return bandRows_;
+}
+
+int ChunkedMapGenerator::regionAt(const Hex &hex) const
+{
+    // The nearest center is at most 14 tiles away, so it has to be within two
+    // cells in each direction.  Ties go to the lowest region number.
+    const int cx = hex.x / CELL_SIZE;
+    const int cy = hex.y / CELL_SIZE;
+    int nearest = RandomMap::invalidIndex;
+    int nearestDist = std::numeric_limits<int>::max();
+    for (int y = std::max(cy - 2, 0); y <= std::min(cy + 2, cellsPerRow_ - 1); ++y) {
+        for (int x = std::max(cx - 2, 0); x <= std::min(cx + 2, cellsPerRow_ - 1); ++x) {
+            const int region = y * cellsPerRow_ + x;
+            const int dist = hexDistance(hex, regionCenters_[region]);
+            if (dist < nearestDist) {
+                nearest = region;
+                nearestDist = dist;
+            }
+        }
+    }
+
+    return nearest;
+}
+
+void ChunkedMapGenerator::rowRegions(int y, std::span<int> regions) const
+{
+    // Measure each cell's worth of the row against all the centers nearby at
+    // once, in the same order regionAt() checks them.
+    std::array<int, CELL_SIZE> xs;
+    std::array<int, CELL_SIZE> ys;
+    std::array<int, CELL_SIZE> nearestDist;
+    ys.fill(y);
+
+    const int cy = y / CELL_SIZE;
+    for (int cx = 0; cx < cellsPerRow_; ++cx) {
+        const int xBegin = cx * CELL_SIZE;
+        const int n = std::min(CELL_SIZE, width_ - xBegin);
+        std::iota(begin(xs), end(xs), xBegin);
+        nearestDist.fill(std::numeric_limits<int>::max());
+
+        for (int y2 = std::max(cy - 2, 0); y2 <= std::min(cy + 2, cellsPerRow_ - 1); ++y2) {
+            for (int x2 = std::max(cx - 2, 0); x2 <= std::min(cx + 2, cellsPerRow_ - 1); ++x2) {
+                const int region = y2 * cellsPerRow_ + x2;
+                hexUpdateNearest(regionCenters_[region], region,
+                                 std::span(xs).first(n),
+                                 std::span(ys).first(n),
+                                 std::span(nearestDist).first(n),
+                                 regions.subspan(xBegin, n));
+            }
+        }
+    }
+}
+
+Terrain ChunkedMapGenerator::terrainAt(int region) const
+{
+    // Same mix of terrain at each altitude as RandomMap::assignTerrain().
+    const Terrain lowAlt[] = {Terrain::water, Terrain::desert, Terrain::swamp};
+    const Terrain medAlt[] = {Terrain::grass, Terrain::dirt};
+    const Terrain highAlt[] = {Terrain::snow, Terrain::dirt};
+
+    // Sample the noise once per cell so neighboring regions have similar
+    // altitudes.
+    const double value = altitudeNoise_.get(region % cellsPerRow_, region / cellsPerRow_);
+    const int altitude = std::clamp(
+        static_cast<int>((value + 1.0) / 2.0 * (RandomMap::maxAltitude + 1)),
+        0, RandomMap::maxAltitude);
+
+    const auto h = stream_value(seed_, terrainStream, region);
+    if (altitude == 0) {
+        return lowAlt[h % std::size(lowAlt)];
+    }
+    else if (altitude == RandomMap::maxAltitude) {
+        return highAlt[h % std::size(highAlt)];
+    }
+    return medAlt[h % std::size(medAlt)];
+}
+
+void ChunkedMapGenerator::placeCastles()
+{
+    // Start with a random hex in each of the four corners, like RandomMap.
+    // Search outward from there for the nearest spot where the whole castle fits
+    // in one land region.  Stay within that corner's quarter of the map.
+    const int quarter = std::max(width_ / 4, 1);
+    const int half = (width_ + 1) / 2;
+    const Hex corners[] = {
+        {0, 0},
+        {width_ - 1, quarter - 1},
+        {quarter - 1, width_ - 1},
+        {width_ - 1, width_ - 1}
+    };
+    const int signs[][2] = {{1, 1}, {-1, -1}, {-1, -1}, {-1, -1}};
+    const Hex boxOrigins[] = {
+        {0, 0},
+        {width_ - half, 0},
+        {0, width_ - half},
+        {width_ - half, width_ - half}
+    };
+
+    std::vector<int> castleRegions;
+    for (int c = 0; c < 4; ++c) {
+        const auto h = stream_value(seed_, castleStream, c);
+        const Hex offset(h % quarter, (h / quarter) % quarter);
+        const Hex start(corners[c].x + signs[c][0] * offset.x,
+                        corners[c].y + signs[c][1] * offset.y);
+
+        const Hex origin = boxOrigins[c];
+        auto inBox = [origin, half] (const Hex &hex) {
+            return hex.x >= origin.x && hex.x < origin.x + half &&
+                hex.y >= origin.y && hex.y < origin.y + half;
+        };
+        auto boxIndex = [origin, half] (const Hex &hex) {
+            return (hex.y - origin.y) * half + (hex.x - origin.x);
+        };
+
+        auto validSpot = [this, &castleRegions] (const Hex &center) {
+            const int region = regionAt(center);
+            if (regionTerrain_[region] == Terrain::water ||
+                std::ranges::find(castleRegions, region) != std::end(castleRegions))
+            {
+                return false;
+            }
+            return std::ranges::all_of(hexCircle(center, 2), [this, region] (auto &hex) {
+                return hex.x >= 0 && hex.x < width_ && hex.y >= 0 && hex.y < width_ &&
+                    regionAt(hex) == region;
+            });
+        };
+
+        std::vector<signed char> visited(half * half, 0);
+        std::deque<Hex> bfsQ = {start};
+        visited[boxIndex(start)] = 1;
+        Hex found;
+        while (!bfsQ.empty() && !found) {
+            const Hex hex = bfsQ.front();
+            bfsQ.pop_front();
+            if (validSpot(hex)) {
+                found = hex;
+                break;
+            }
+
+            for (auto &nbr : hex.getAllNeighbors()) {
+                if (inBox(nbr) && !visited[boxIndex(nbr)]) {
+                    visited[boxIndex(nbr)] = 1;
+                    bfsQ.push_back(nbr);
+                }
+            }
+        }
+
+        if (!found) {
+            throw std::runtime_error("Couldn't find valid castle spot");
+        }
+        castles_.push_back(found);
+        castleRegions.push_back(regionAt(found));
+    }
+}
+
+void ChunkedMapGenerator::writeBand(int yBegin,
+                                    int yEnd,
+                                    BinaryStreamWriter &file,
+                                    std::vector<std::pair<int, int>> &regionPairs) const
+{
+    // Work on a window of rows around the band.  Tile numbers are relative to
+    // the top of the window.
+    const int winBegin = std::max(yBegin - MARGIN_ROWS, 0);
+    const int winEnd = std::min(yEnd + MARGIN_ROWS, width_);
+    const int numTiles = (winEnd - winBegin) * width_;
+    const int coreBegin = (yBegin - winBegin) * width_;
+    const int coreEnd = (yEnd - winBegin) * width_;
+
+    auto hexAt = [this, winBegin] (int tile) {
+        return Hex{tile % width_, winBegin + tile / width_};
+    };
+    auto inWindow = [this, winBegin, winEnd] (const Hex &hex) {
+        return hex.x >= 0 && hex.x < width_ && hex.y >= winBegin && hex.y < winEnd;
+    };
+    auto tileAt = [this, winBegin] (const Hex &hex) {
+        return (hex.y - winBegin) * width_ + hex.x;
+    };
+
+    std::vector<int> tileRegions(numTiles);
+    parallel_blocks(winEnd - winBegin, numThreads_,
+        [this, winBegin, &tileRegions] (int rowBegin, int rowEnd, int) {
+            for (int row = rowBegin; row < rowEnd; ++row) {
+                rowRegions(winBegin + row,
+                           std::span(tileRegions).subspan(row * width_, width_));
+            }
+        });
+
+    // Region numbers go up one row of cells at a time, so the regions in the
+    // window are a contiguous range.
+    const auto [minRegion, maxRegion] = std::ranges::minmax(tileRegions);
+    const int numLocalRegions = maxRegion - minRegion + 1;
+
+    // A region is complete if we can see all of its tiles and their neighbors.
+    // Only complete regions touching the band get their obstacles fixed up.
+    std::vector<signed char> complete(numLocalRegions, 0);
+    std::vector<signed char> inBand(numLocalRegions, 0);
+    for (int r = 0; r < numLocalRegions; ++r) {
+        const int centerY = regionCenters_[minRegion + r].y;
+        complete[r] = (winBegin == 0 || centerY - REGION_REACH - 1 >= winBegin) &&
+            (winEnd == width_ || centerY + REGION_REACH + 1 < winEnd);
+    }
+    for (int i = coreBegin; i < coreEnd; ++i) {
+        inBand[tileRegions[i] - minRegion] = 1;
+    }
+
+    // Castles and obstacles, same as RandomMap::placeCastles() and
+    // assignObstacles().
+    TileBitset obstacles(numTiles);
+    TileBitset occupied(numTiles);
+    TileBitset walkable(numTiles, true);
+    for (auto &castle : castles_) {
+        for (auto &hex : hexCircle(castle, 2)) {
+            if (inWindow(hex)) {
+                occupied.set(tileAt(hex));
+            }
+        }
+        for (auto dir : {HexDir::n, HexDir::ne, HexDir::se, HexDir::sw, HexDir::nw}) {
+            const auto hex = castle.getNeighbor(dir);
+            if (inWindow(hex)) {
+                walkable.reset(tileAt(hex));
+            }
+        }
+    }
+    {
+        const auto values = obstacleNoise_.getRows(width_, winBegin, winEnd, numThreads_);
+        for (int i = 0; i < numTiles; ++i) {
+            if (values[i] > RandomMap::obstacleLevel && !occupied[i]) {
+                obstacles.set(i);
+                occupied.set(i);
+                walkable.reset(i);
+            }
+        }
+    }
+    auto clearObstacle = [&] (int tile) {
+        if (obstacles[tile]) {
+            obstacles.reset(tile);
+            occupied.reset(tile);
+            walkable.set(tile);
+        }
+    };
+
+    // Make sure every region has a way out to one of its neighbors.  Unlike
+    // RandomMap::avoidIsolatedRegions(), every region decides before anything
+    // is cleared, so the result doesn't depend on the order we visit regions
+    // in.  A region that's closed off clears its first border crossing that
+    // isn't blocked by an object.
+    std::vector<signed char> hasExit(numLocalRegions, 0);
+    std::vector<std::pair<int, int>> exitToClear(numLocalRegions, {-1, -1});
+    for (int i = 0; i < numTiles; ++i) {
+        const int r = tileRegions[i] - minRegion;
+        if (!complete[r] || hasExit[r]) {
+            continue;
+        }
+
+        for (auto &nbrHex : hexAt(i).getAllNeighbors()) {
+            if (!inWindow(nbrHex)) {
+                continue;
+            }
+            const int nbr = tileAt(nbrHex);
+            if (tileRegions[nbr] == tileRegions[i]) {
+                continue;
+            }
+            if (walkable[i] && walkable[nbr]) {
+                hasExit[r] = 1;
+                break;
+            }
+            if (exitToClear[r].first < 0 &&
+                obstacles[i] &&
+                (obstacles[nbr] || walkable[nbr]))
+            {
+                exitToClear[r] = {i, nbr};
+            }
+        }
+    }
+    for (int r = 0; r < numLocalRegions; ++r) {
+        if (complete[r] && !hasExit[r] && exitToClear[r].first >= 0) {
+            clearObstacle(exitToClear[r].first);
+            clearObstacle(exitToClear[r].second);
+        }
+    }
+
+    // Connect the isolated pockets within each region, the same way as
+    // RandomMap::avoidIsolatedTiles().  First, list the tiles of each region.
+    std::vector<int> regionOffsets(numLocalRegions + 1, 0);
+    for (int region : tileRegions) {
+        ++regionOffsets[region - minRegion + 1];
+    }
+    std::partial_sum(begin(regionOffsets), end(regionOffsets), begin(regionOffsets));
+    std::vector<int> regionTiles(numTiles);
+    {
+        auto next = regionOffsets;
+        for (int i = 0; i < numTiles; ++i) {
+            regionTiles[next[tileRegions[i] - minRegion]++] = i;
+        }
+    }
+
+    DisjointSets pockets(numTiles);
+    auto joinNeighbors = [&] (int tile) {
+        for (auto &nbrHex : hexAt(tile).getAllNeighbors()) {
+            if (inWindow(nbrHex)) {
+                const int nbr = tileAt(nbrHex);
+                if (walkable[nbr] && tileRegions[nbr] == tileRegions[tile]) {
+                    pockets.join(tile, nbr);
+                }
+            }
+        }
+    };
+    walkable.forEachSet(joinNeighbors);
+
+    std::vector<int> cost(numTiles, -1);
+    std::vector<int> cameFrom(numTiles, RandomMap::invalidIndex);
+    std::deque<int> bfsQ;
+    std::vector<int> isolated;
+    for (int r = 0; r < numLocalRegions; ++r) {
+        if (!complete[r] || !inBand[r]) {
+            continue;
+        }
+        const auto tiles = std::span(regionTiles).subspan(
+            regionOffsets[r], regionOffsets[r + 1] - regionOffsets[r]);
+
+        int mainRoot = RandomMap::invalidIndex;
+        for (int tile : tiles) {
+            if (!walkable[tile]) {
+                continue;
+            }
+            const int root = pockets.find(tile);
+            if (mainRoot == RandomMap::invalidIndex ||
+                pockets.setSize(root) > pockets.setSize(mainRoot))
+            {
+                mainRoot = root;
+            }
+        }
+
+        isolated.clear();
+        for (int tile : tiles) {
+            if (walkable[tile]) {
+                if (pockets.find(tile) == mainRoot) {
+                    cost[tile] = 0;
+                    bfsQ.push_back(tile);
+                }
+                else {
+                    isolated.push_back(tile);
+                }
+            }
+        }
+        if (isolated.empty()) {
+            bfsQ.clear();
+            continue;
+        }
+
+        while (!bfsQ.empty()) {
+            const int tile = bfsQ.front();
+            bfsQ.pop_front();
+
+            for (auto &nbrHex : hexAt(tile).getAllNeighbors()) {
+                if (!inWindow(nbrHex)) {
+                    continue;
+                }
+                const int nbr = tileAt(nbrHex);
+                if (tileRegions[nbr] != tileRegions[tile] ||
+                    (!walkable[nbr] && !obstacles[nbr]))
+                {
+                    continue;
+                }
+
+                const int nbrCost = cost[tile] + (obstacles[nbr] ? 1 : 0);
+                if (cost[nbr] < 0 || nbrCost < cost[nbr]) {
+                    cost[nbr] = nbrCost;
+                    cameFrom[nbr] = tile;
+                    if (obstacles[nbr]) {
+                        bfsQ.push_back(nbr);
+                    }
+                    else {
+                        bfsQ.push_front(nbr);
+                    }
+                }
+            }
+        }
+
+        for (int tile : isolated) {
+            if (cost[tile] < 0 || pockets.same(tile, mainRoot)) {
+                continue;
+            }
+            for (int t = tile; t != RandomMap::invalidIndex; t = cameFrom[t]) {
+                clearObstacle(t);
+                joinNeighbors(t);
+            }
+        }
+    }
+
+    // Write out the rows of the band itself.
+    const int coreSize = coreEnd - coreBegin;
+    file.append(MapFile::tileRegions,
+                std::span<const int>(tileRegions).subspan(coreBegin, coreSize));
+    file.append(MapFile::tileObstacles, slice_bits(obstacles, coreBegin, coreSize).words());
+    file.append(MapFile::tileOccupied, slice_bits(occupied, coreBegin, coreSize).words());
+    file.append(MapFile::tileWalkable, slice_bits(walkable, coreBegin, coreSize).words());
+
+    std::vector<std::pair<int, int>> bandPairs;
+    for (int i = coreBegin; i < coreEnd; ++i) {
+        for (auto &nbrHex : hexAt(i).getAllNeighbors()) {
+            if (inWindow(nbrHex) && tileRegions[tileAt(nbrHex)] != tileRegions[i]) {
+                bandPairs.emplace_back(tileRegions[i], tileRegions[tileAt(nbrHex)]);
+            }
+        }
+    }
+    std::ranges::sort(bandPairs);
+    const auto dups = std::ranges::unique(bandPairs);
+    bandPairs.erase(dups.begin(), dups.end());
+    regionPairs.insert(end(regionPairs), begin(bandPairs), end(bandPairs));
+}
+
+std::vector<int> ChunkedMapGenerator::regionCastleDistance(
+    const std::vector<std::pair<int, int>> &regionPairs) const
+{
+    auto pairs = regionPairs;
+    std::ranges::sort(pairs);
+    const auto dups = std::ranges::unique(pairs);
+    pairs.erase(dups.begin(), dups.end());
+
+    // Sorted pairs are already grouped by region, find where each one starts.
+    std::vector<int> offsets(numRegions() + 1, 0);
+    for (auto [region, nbr] : pairs) {
+        ++offsets[region + 1];
+    }
+    std::partial_sum(begin(offsets), end(offsets), begin(offsets));
+
+    std::vector<int> dist(numRegions(), -1);
+    std::vector<int> bfsQ;
+    for (auto &hex : castles_) {
+        const int region = regionAt(hex);
+        if (dist[region] < 0) {
+            dist[region] = 0;
+            bfsQ.push_back(region);
+        }
+    }
+    for (int head = 0; head < ssize(bfsQ); ++head) {
+        const int region = bfsQ[head];
+        for (int p = offsets[region]; p < offsets[region + 1]; ++p) {
+            const int nbr = pairs[p].second;
+            if (dist[nbr] < 0) {
+                dist[nbr] = dist[region] + 1;
+                bfsQ.push_back(nbr);
+            }
+        }
+    }
+
+    return dist;
+}
@@ -0,0 +1,95 @@
+/*
+    Copyright (C) 2025 by Michael Kristofik <kristo605@gmail.com>
+    Part of the Champions of Anduran project.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    or at your option any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY.
+
+    See the COPYING.txt file for more details.
+*/
+#ifndef CHUNKED_MAP_GENERATOR_H
+#define CHUNKED_MAP_GENERATOR_H
+
+#include "Noise.h"
+#include "hex_utils.h"
+#include "terrain.h"
+#include <span>
+#include <utility>
+#include <vector>
+
+class BinaryStreamWriter;
+
+
+// Generate maps too big to hold in memory all at once (4096 wide and up).  The
+// map is built a band of rows at a time, and each finished band goes straight
+// to the output file, so memory use depends on the band size, not the map
+// size.  The result can be loaded like any other map file.
+//
+// Each band is generated with enough extra rows on either side to see every
+// region that touches it in full.  The same seed and width always generate the
+// same map, whatever the band size.
+//
+// How this differs from RandomMap:
+// - Region centers come from a jittered grid, one per 8x8 cell, so any band can
+//   work out which regions it touches without seeing the rest of the map.
+// - Terrain comes from a smooth altitude noise at each region center, instead
+//   of a random walk across the region graph.
+// - Castles go in the four corners, but there are no other objects or armies.
+//   Placing those fairly needs the whole map at once.
+class ChunkedMapGenerator
+{
+public:
+    static constexpr int defaultBandRows = 256;
+
+    ChunkedMapGenerator(int width,
+                        unsigned int seed,
+                        int bandRows = defaultBandRows,
+                        int numThreads = 1);
+
+    // Generate the map, writing each band to a binary map file as it's
+    // finished.  Throws std::runtime_error if the file can't be written.
+    void writeBinaryFile(const char *filename) const;
+
+    // Same, in JSON format.  The binary file is written first and converted
+    // through a memory map, then removed.
+    void writeJsonFile(const char *filename) const;
+
+    int width() const;
+    int numRegions() const;
+    int bandRows() const;  // may be rounded up from what was asked for
+
+private:
+    int regionAt(const Hex &hex) const;
+
+    // Same as calling regionAt() for every tile in row y.
+    void rowRegions(int y, std::span<int> regions) const;
+
+    Terrain terrainAt(int region) const;
+    void placeCastles();
+
+    // Generate rows [yBegin, yEnd) and append them to the file.  Also collect
+    // the pairs of regions that touch in those rows.
+    void writeBand(int yBegin,
+                   int yEnd,
+                   BinaryStreamWriter &file,
+                   std::vector<std::pair<int, int>> &regionPairs) const;
+
+    std::vector<int> regionCastleDistance(
+        const std::vector<std::pair<int, int>> &regionPairs) const;
+
+    int width_;
+    unsigned int seed_;
+    int bandRows_;
+    int numThreads_;
+    int cellsPerRow_;
+    Noise altitudeNoise_;
+    Noise obstacleNoise_;
+    std::vector<Hex> regionCenters_;
+    std::vector<Terrain> regionTerrain_;
+    std::vector<Hex> castles_;
+};
+
+#endif
@@ -0,0 +1,96 @@
+/*
+    Copyright (C) 2025 by Michael Kristofik <kristo605@gmail.com>
+    Part of the Champions of Anduran project.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    or at your option any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY.
+
+    See the COPYING.txt file for more details.
+*/
+#ifndef DISJOINT_SETS_H
+#define DISJOINT_SETS_H
+
+#include <cassert>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+// Disjoint-set forest (union-find) over the integers [0, size), e.g. tile
+// indexes.  Each element starts in a set by itself.  Parents and set sizes are
+// flat arrays.  find() halves the path as it goes and join() hangs the smaller
+// tree under the larger, so any sequence of operations is nearly linear.
+class DisjointSets
+{
+public:
+    explicit DisjointSets(int size = 0);
+
+    int size() const;
+
+    // Return the representative element of the set containing 'elem'.
+    int find(int elem);
+
+    // Merge the sets containing a and b.  Return false if they were already
+    // the same set.
+    bool join(int a, int b);
+
+    bool same(int a, int b);
+    int setSize(int elem);
+
+private:
+    std::vector<int> parent_;
+    std::vector<int> setSize_;
+};
+
+
+inline DisjointSets::DisjointSets(int size)
+    : parent_(size),
+    setSize_(size, 1)
+{
+    std::iota(std::begin(parent_), std::end(parent_), 0);
+}
+
+inline int DisjointSets::size() const
+{
+    return std::ssize(parent_);
+}
+
+inline int DisjointSets::find(int elem)
+{
+    assert(elem >= 0 && elem < size());
+    while (parent_[elem] != elem) {
+        parent_[elem] = parent_[parent_[elem]];
+        elem = parent_[elem];
+    }
+    return elem;
+}
+
+inline bool DisjointSets::join(int a, int b)
+{
+    a = find(a);
+    b = find(b);
+    if (a == b) {
+        return false;
+    }
+
+    if (setSize_[a] < setSize_[b]) {
+        std::swap(a, b);
+    }
+    parent_[b] = a;
+    setSize_[a] += setSize_[b];
+    return true;
+}
+
+inline bool DisjointSets::same(int a, int b)
+{
+    return find(a) == find(b);
+}
+
+inline int DisjointSets::setSize(int elem)
+{
+    return setSize_[find(elem)];
+}
+
+#endif
@@ -1,5 +1,5 @@
 /*
-    Copyright (C) 2016-2024 by Michael Kristofik <kristo605@gmail.com>
+    Copyright (C) 2016-2025 by Michael Kristofik <kristo605@gmail.com>
     Part of the Champions of Anduran project.
 
     This program is free software; you can redistribute it and/or modify
@@ -14,14 +14,24 @@
 #define FLAT_MULTIMAP_H
 
 #include <algorithm>
+#include <cassert>
 #include <compare>
+#include <concepts>
+#include <functional>
 #include <ranges>
+#include <span>
 #include <tuple>
+#include <utility>
 #include <vector>
 
 // Implementation of a multimap on top of contiguous storage. Performs best if all
 // insertions are done first, followed by all reads. This class differs from
 // std::multimap by not allowing duplicate values for each key.
+//
+// Multimaps with small non-negative integer keys can be frozen once all the
+// insertions are done.  That builds an index of where each key's values start
+// (compressed sparse row format), so lookups are a pair of array reads instead
+// of a binary search.
 template <typename K, typename V>
 class FlatMultimap
 {
@@ -64,13 +74,30 @@ public:
     template <typename T>
     ValueRange find(const T &key);
 
+    // Same as above, but all insertions must already be sorted out, either by
+    // calling one of the non-const functions or by freezing.
+    template <typename T>
+    ValueRange find(const T &key) const;
+
     void reserve(int capacity);
     void shrink_to_fit();
 
+    // Sort the elements and build the index for constant-time lookups.
+    // Inserting again discards the index.
+    void freeze() requires std::integral<K>;
+    bool frozen() const;
+
+    // Contents of a frozen multimap, for saving it and later restoring it
+    // without sorting.  The data passed to assignSorted() must already be sorted
+    // with no duplicates, such as the output of frozenData().
+    std::span<const KeyValue> frozenData() const;
+    void assignSorted(std::span<const KeyValue> data);
+
 private:
     void sortAndPrune();
 
     container_type data_;
+    std::vector<int> offsets_;  // key k is at [offsets_[k], offsets_[k + 1])
     bool isDirty_;
 
 // *** IMPLEMENTATION DETAILS ***
@@ -139,6 +166,7 @@ private:
 template <typename K, typename V>
 FlatMultimap<K, V>::FlatMultimap()
     : data_(),
+    offsets_(),
     isDirty_(false)
 {
 }
@@ -167,6 +195,7 @@ template <typename K, typename V>
 void FlatMultimap<K, V>::insert(const K &key, const V &value)
 {
     data_.emplace_back(key, value);
+    offsets_.clear();
     isDirty_ = true;
 }
 
@@ -175,6 +204,24 @@ template <typename T>
 typename FlatMultimap<K, V>::ValueRange FlatMultimap<K, V>::find(const T &key)
 {
     sortAndPrune();
+    return std::as_const(*this).find(key);
+}
+
+template <typename K, typename V>
+template <typename T>
+typename FlatMultimap<K, V>::ValueRange FlatMultimap<K, V>::find(const T &key) const
+{
+    assert(!isDirty_);
+
+    if constexpr (std::integral<K>) {
+        if (frozen()) {
+            if (key < 0 || key >= ssize(offsets_) - 1) {
+                return {ValueIterator(cend(data_)), ValueIterator(cend(data_))};
+            }
+            return {ValueIterator(cbegin(data_) + offsets_[key]),
+                    ValueIterator(cbegin(data_) + offsets_[key + 1])};
+        }
+    }
 
     const auto range = equal_range(cbegin(data_), cend(data_), key);
     return {ValueIterator(range.first), ValueIterator(range.second)};
@@ -193,6 +240,52 @@ void FlatMultimap<K, V>::shrink_to_fit()
     data_.shrink_to_fit();
 }
 
+template <typename K, typename V>
+void FlatMultimap<K, V>::freeze() requires std::integral<K>
+{
+    sortAndPrune();
+    offsets_.clear();
+    if (data_.empty()) {
+        return;
+    }
+
+    assert(data_.front().key >= 0);
+    const int numKeys = data_.back().key + 1;
+    offsets_.resize(numKeys + 1);
+
+    // Each key starts where the first element not less than it is.
+    int pos = 0;
+    for (int k = 0; k <= numKeys; ++k) {
+        while (pos < ssize(data_) && data_[pos].key < k) {
+            ++pos;
+        }
+        offsets_[k] = pos;
+    }
+}
+
+template <typename K, typename V>
+bool FlatMultimap<K, V>::frozen() const
+{
+    return !offsets_.empty();
+}
+
+template <typename K, typename V>
+std::span<const typename FlatMultimap<K, V>::KeyValue>
+    FlatMultimap<K, V>::frozenData() const
+{
+    assert(frozen() || data_.empty());
+    return data_;
+}
+
+template <typename K, typename V>
+void FlatMultimap<K, V>::assignSorted(std::span<const KeyValue> data)
+{
+    assert(std::ranges::adjacent_find(data, std::greater_equal{}) == std::end(data));
+    data_.assign(std::begin(data), std::end(data));
+    offsets_.clear();
+    isDirty_ = false;
+}
+
 template <typename K, typename V>
 void FlatMultimap<K, V>::sortAndPrune()
 {
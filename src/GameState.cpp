@@ -1,5 +1,5 @@
 /*
-    Copyright (C) 2019-2024 by Michael Kristofik <kristo605@gmail.com>
+    Copyright (C) 2019-2025 by Michael Kristofik <kristo605@gmail.com>
     Part of the Champions of Anduran project.
 
     This program is free software; you can redistribute it and/or modify
@@ -21,7 +21,8 @@ GameState::GameState(const RandomMap &rmap)
     armies_(),
     zoc_(),
     rmap_(&rmap),
-    objConfig_(&rmap_->getObjectConfig())
+    objConfig_(&rmap_->getObjectConfig()),
+    version_(0)
 {
 }
 
@@ -29,6 +30,7 @@ void GameState::add_object(const GameObject &obj)
 {
     objects_.insert(obj);
     update_zoc();
+    ++version_;
 }
 
 GameObject GameState::get_object(int id) const
@@ -47,6 +49,7 @@ void GameState::update_object(const GameObject &obj)
 
     entityIndex.replace(iter, obj);
     update_zoc();
+    ++version_;
 }
 
 void GameState::remove_object(int id)
@@ -60,6 +63,12 @@ void GameState::remove_object(int id)
     obj.hex = {};
     entityIndex.replace(iter, obj);
     update_zoc();
+    ++version_;
+}
+
+unsigned int GameState::version() const
+{
+    return version_;
 }
 
 int GameState::num_objects_in_hex(const Hex &hex) const
@@ -63,6 +63,10 @@ public:
     void update_object(const GameObject &obj);
     void remove_object(int id);
 
+    // Goes up every time an object is added, changed, or removed, so anything
+    // computed from the objects can tell when it's out of date.
+    unsigned int version() const;
+
     // These return a std::ranges::subrange (MultiIndex container makes the
     // actual type awkward to spell).
     auto objects_in_hex(const Hex &hex) const;
@@ -112,6 +116,7 @@ private:
     boost::container::flat_map<Hex, int> zoc_;
     const RandomMap *rmap_;
     const ObjectManager *objConfig_;
+    unsigned int version_;
 };
 
 inline auto GameState::objects_in_hex(const Hex &hex) const
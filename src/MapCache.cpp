@@ -0,0 +1,136 @@
+/*
+    Copyright (C) 2025 by Michael Kristofik <kristo605@gmail.com>
+    Part of the Champions of Anduran project.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    or at your option any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY.
+
+    See the COPYING.txt file for more details.
+*/
+#include "MapCache.h"
+#include "log_utils.h"
+
+#include <cstdlib>
+#include <format>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string_view>
+#include <system_error>
+
+namespace
+{
+    // source: FNV-1a, http://www.isthe.com/chongo/tech/comp/fnv/
+    uint64_t hash_file(const std::string &filename)
+    {
+        std::ifstream f(filename, std::ios::binary);
+        if (!f) {
+            log_warn("couldn't hash file: " + filename);
+            return 0;
+        }
+
+        uint64_t hash = 0xcbf29ce484222325ull;
+        for (auto i = std::istreambuf_iterator<char>(f);
+             i != std::istreambuf_iterator<char>();
+             ++i)
+        {
+            hash ^= static_cast<unsigned char>(*i);
+            hash *= 0x100000001b3ull;
+        }
+        return hash;
+    }
+}
+
+
+MapCache::MapCache(const std::string &dir, const std::string &objectConfigFile)
+    : dir_(dir),
+    configHash_(hash_file(objectConfigFile))
+{
+}
+
+std::filesystem::path MapCache::filename(unsigned int seed, int width) const
+{
+    return dir_ / std::format("map-{}-{}-{:016x}.map", seed, width, configHash_);
+}
+
+RandomMap MapCache::get(unsigned int seed,
+                        int width,
+                        const ObjectManager &objMgr,
+                        int numThreads) const
+{
+    auto path = filename(seed, width);
+    if (std::filesystem::exists(path)) {
+        // Files written by an older version of the binary format don't load,
+        // just replace them.
+        try {
+            return RandomMap(path.string().c_str(), objMgr);
+        }
+        catch (const std::runtime_error &) {
+            log_warn("regenerating unreadable cached map: " + path.string());
+        }
+    }
+
+    log_info(std::format("generating map seed {} width {}", seed, width));
+    RandomMap rmap(width, seed, objMgr, numThreads);
+
+    // Write to a temporary file first so that a program interrupted partway
+    // through never leaves a truncated map in the cache.  Failing to save is
+    // not an error, we just regenerate next time.
+    std::error_code ec;
+    std::filesystem::create_directories(dir_, ec);
+    if (ec) {
+        log_warn(std::format("couldn't create map cache: {}", ec.message()));
+        return rmap;
+    }
+
+    auto tmpPath = path;
+    tmpPath += ".tmp";
+    try {
+        rmap.writeBinaryFile(tmpPath.string().c_str());
+    }
+    catch (const std::runtime_error &) {
+        return rmap;  // already logged
+    }
+    std::filesystem::rename(tmpPath, path, ec);
+    if (ec) {
+        log_warn(std::format("couldn't save map to cache: {}", ec.message()));
+        std::filesystem::remove(tmpPath, ec);
+    }
+
+    return rmap;
+}
+
+
+MapArgs parse_map_args(int argc, char *argv[])
+{
+    MapArgs args;
+    for (int i = 1; i + 1 < argc; ++i) {
+        std::string_view arg = argv[i];
+        if (arg == "-s") {
+            args.seed = std::strtoul(argv[++i], nullptr, 10);
+        }
+        else if (arg == "-w") {
+            args.width = std::atoi(argv[++i]);
+        }
+        else if (arg == "-j") {
+            args.numThreads = std::atoi(argv[++i]);
+        }
+    }
+
+    return args;
+}
+
+RandomMap load_map(const MapArgs &args,
+                   const char *filename,
+                   const ObjectManager &objMgr)
+{
+    if (!args.seed) {
+        return RandomMap(filename, objMgr);
+    }
+
+    MapCache cache("cache", "data/objects.json");
+    return cache.get(*args.seed, args.width, objMgr, args.numThreads);
+}
@@ -0,0 +1,68 @@
+/*
+    Copyright (C) 2025 by Michael Kristofik <kristo605@gmail.com>
+    Part of the Champions of Anduran project.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    or at your option any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY.
+
+    See the COPYING.txt file for more details.
+*/
+#ifndef MAP_CACHE_H
+#define MAP_CACHE_H
+
+#include "RandomMap.h"
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+
+class ObjectManager;
+
+
+// Generated maps saved on disk, so we only pay for generating each one once.
+// Maps are keyed by seed, width, and a hash of the object config file they were
+// generated with.  Editing the object config means all new map files.  Maps are
+// saved in the binary format so loading them is cheap.
+class MapCache
+{
+public:
+    MapCache(const std::string &dir, const std::string &objectConfigFile);
+
+    std::filesystem::path filename(unsigned int seed, int width) const;
+
+    // Load the map with the given seed and width, generating and saving it
+    // first if it isn't in the cache yet.
+    RandomMap get(unsigned int seed,
+                  int width,
+                  const ObjectManager &objMgr,
+                  int numThreads = 1) const;
+
+private:
+    std::filesystem::path dir_;
+    uint64_t configHash_;
+};
+
+
+// Command line options for the programs that need a map.
+//   -s seed     pull this map from the cache
+//   -w width    map size to go with the seed
+//   -j threads  split map generation across threads
+struct MapArgs
+{
+    std::optional<unsigned int> seed;
+    int width = 36;
+    int numThreads = 1;
+};
+
+MapArgs parse_map_args(int argc, char *argv[]);
+
+// Load the map named by the command line options, or from 'filename' if no seed
+// was given.
+RandomMap load_map(const MapArgs &args,
+                   const char *filename,
+                   const ObjectManager &objMgr);
+
+#endif
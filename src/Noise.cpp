@@ -0,0 +1,66 @@
+/*
+    Copyright (C) 2025 by Michael Kristofik <kristo605@gmail.com>
+    Part of the Champions of Anduran project.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    or at your option any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY.
+
+    See the COPYING.txt file for more details.
+*/
+#include "Noise.h"
+#include "open-simplex-noise.h"
+#include "thread_utils.h"
+
+#include <cassert>
+
+namespace
+{
+    const double NOISE_FEATURE_SIZE = 2.0;
+}
+
+
+Noise::Noise(unsigned int seed)
+    : ctx_()
+{
+    osn_context *tmp = nullptr;
+    open_simplex_noise(seed, &tmp);
+    ctx_.reset(tmp, open_simplex_noise_free);
+}
+
+double Noise::get(int x, int y) const
+{
+    // Stole the feature size concept from open-simplex-noise-test.c. I don't
+    // know what it means but it seems to smooth out the noise values over a
+    // range of coordinates.
+    return open_simplex_noise2(ctx_.get(),
+                               x / NOISE_FEATURE_SIZE,
+                               y / NOISE_FEATURE_SIZE);
+}
+
+std::vector<double> Noise::getAll(int width, int numThreads) const
+{
+    return getRows(width, 0, width, numThreads);
+}
+
+std::vector<double> Noise::getRows(int width, int yBegin, int yEnd, int numThreads) const
+{
+    assert(yBegin <= yEnd);
+
+    // Each thread fills in a block of rows.
+    std::vector<double> values(static_cast<size_t>(width) * (yEnd - yBegin));
+    auto fillRows = [this, width, yBegin, &values] (int rowBegin, int rowEnd, int) {
+        open_simplex_noise2_grid(ctx_.get(),
+                                 0,
+                                 yBegin + rowBegin,
+                                 width,
+                                 rowEnd - rowBegin,
+                                 NOISE_FEATURE_SIZE,
+                                 values.data() + static_cast<size_t>(rowBegin) * width);
+    };
+    parallel_blocks(yEnd - yBegin, numThreads, fillRows);
+
+    return values;
+}
@@ -0,0 +1,42 @@
+/*
+    Copyright (C) 2025 by Michael Kristofik <kristo605@gmail.com>
+    Part of the Champions of Anduran project.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    or at your option any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY.
+
+    See the COPYING.txt file for more details.
+*/
+#ifndef NOISE_H
+#define NOISE_H
+
+#include <memory>
+#include <vector>
+
+struct osn_context;
+
+
+// RAII wrapper around the Open Simplex Noise library in C.
+class Noise
+{
+public:
+    explicit Noise(unsigned int seed);
+
+    // Generate a value in the range [-1.0, 1.0] for the given coordinates.
+    double get(int x, int y) const;
+
+    // Generate values for every tile of a square map at once, in tile index
+    // order.  Same results as calling get() for each tile.
+    std::vector<double> getAll(int width, int numThreads) const;
+
+    // Same, for rows [yBegin, yEnd) of a map that's 'width' tiles wide.
+    std::vector<double> getRows(int width, int yBegin, int yEnd, int numThreads) const;
+
+private:
+    std::shared_ptr<osn_context> ctx_;
+};
+
+#endif
@@ -1,5 +1,5 @@
 /*
-    Copyright (C) 2016-2023 by Michael Kristofik <kristo605@gmail.com>
+    Copyright (C) 2016-2025 by Michael Kristofik <kristo605@gmail.com>
     Part of the Champions of Anduran project.
  
     This program is free software; you can redistribute it and/or modify
@@ -24,9 +24,12 @@ bool operator>(const EstimatedPathCost &lhs, const EstimatedPathCost &rhs)
 }
 
 
-Pathfinder::Pathfinder(const RandomMap &rmap, const GameState &state)
-    : cameFrom_(),
-    costSoFar_(),
+template <typename Queue>
+BasicPathfinder<Queue>::BasicPathfinder(const RandomMap &rmap, const GameState &state)
+    : cameFrom_(rmap.size(), RandomMap::invalidIndex),
+    costSoFar_(rmap.size(), 0),
+    searchStamp_(rmap.size(), 0),
+    curSearch_(0),
     frontier_(),
     rmap_(&rmap),
     game_(&state),
@@ -35,19 +38,32 @@ Pathfinder::Pathfinder(const RandomMap &rmap, const GameState &state)
     region_(-1),
     iDest_(RandomMap::invalidIndex),
     hDest_(),
-    destObject_()
+    destObject_(),
+    tileActions_(rmap.size()),
+    curActions_(0),
+    actionsEntity_(-1),
+    actionsTeam_(Team::neutral),
+    actionsOnWater_(false),
+    actionsVersion_(0),
+    reachCost_(rmap.size(), -1),
+    reachFrom_(rmap.size(), RandomMap::invalidIndex),
+    reachTiles_(),
+    reachTileCost_(),
+    reachEntity_(-1),
+    reachSrc_(),
+    reachMoves_(-1),
+    reachVersion_(0)
 {
 }
 
-Path Pathfinder::find_path(const GameObject &mover, const Hex &hDest)
+template <typename Queue>
+Path BasicPathfinder<Queue>::find_path(const GameObject &mover, const Hex &hDest)
 {
     if (mover.hex == hDest) {
         return {};
     }
 
     Path path;
-    cameFrom_.clear();
-    costSoFar_.clear();
     frontier_.clear();
     mover_ = &mover;
     hDest_ = hDest;
@@ -55,15 +71,22 @@ Path Pathfinder::find_path(const GameObject &mover, const Hex &hDest)
     iSrc_ = rmap_->intFromHex(mover_->hex);
     region_ = rmap_->getRegion(iSrc_);
     destObject_ = game_->hex_action(*mover_, hDest_).obj;
+    update_tile_actions(mover);
 
     // Optimization: skip everything if the destination hex isn't reachable.
     if (!is_reachable(iDest_)) {
         return {};
     }
 
+    // Start a new search.  On the rare occasion the stamp wraps around, old
+    // stamps could look current again, so clear them for real.
+    if (++curSearch_ == 0) {
+        std::ranges::fill(searchStamp_, 0);
+        curSearch_ = 1;
+    }
+
     frontier_.push({iSrc_, 0});
-    cameFrom_.emplace(iSrc_, RandomMap::invalidIndex);
-    costSoFar_.emplace(iSrc_, 0);
+    visit(iSrc_, RandomMap::invalidIndex, 0);
 
     // source: https://www.redblobgames.com/pathfinding/a-star/introduction.html#astar
     while (!frontier_.empty()) {
@@ -75,43 +98,168 @@ Path Pathfinder::find_path(const GameObject &mover, const Hex &hDest)
 
         // Assuming nonzero cost per tile, it will always be less efficient to
         // reach those tiles in two steps (i.e., through this tile) than one.
-        for (auto iNbr : get_neighbors(current.index)) {
+        const auto iNbrs = get_neighbors(current.index);
+
+        // The heuristic makes this A* instead of Dijkstra's.  Estimate for all
+        // the neighbors at once, skipped ones just measure the current tile.
+        Neighbors<int> xs;
+        Neighbors<int> ys;
+        Neighbors<int> estimates;
+        for (int i = 0; i < ssize(iNbrs); ++i) {
+            const int index = rmap_->offGrid(iNbrs[i]) ? current.index : iNbrs[i];
+            const auto hex = rmap_->hexFromInt(index);
+            xs[i] = hex.x;
+            ys[i] = hex.y;
+        }
+        hexDistances(hDest, xs, ys, estimates);
+
+        for (int i = 0; i < ssize(iNbrs); ++i) {
+            const int iNbr = iNbrs[i];
             if (rmap_->offGrid(iNbr)) {
                 continue;
             }
 
             const auto newCost = costSoFar_[current.index] + 1;
-            auto costIter = costSoFar_.find(iNbr);
-            if (costIter != costSoFar_.end() && newCost >= costIter->second) {
+            if (visited(iNbr) && newCost >= costSoFar_[iNbr]) {
                 continue;
             }
-            else if (costIter == costSoFar_.end()) {
-                costSoFar_.emplace(iNbr, newCost);
-            }
-            else {
-                costIter->second = newCost;
-            }
 
-            // heuristic makes this A* instead of Dijkstra's
-            const auto estimate = hexDistance(rmap_->hexFromInt(iNbr), hDest);
-            frontier_.push({iNbr, newCost + estimate});
-            cameFrom_[iNbr] = current.index;
+            visit(iNbr, current.index, newCost);
+            frontier_.push({iNbr, newCost + estimates[i]});
         }
     }
 
     // Walk backwards to produce the path.  If the destination hex wasn't found,
     // the path will be empty.
-    auto fromIter = cameFrom_.find(iDest_);
-    while (fromIter != cameFrom_.end()) {
-        path.push_back(rmap_->hexFromInt(fromIter->first));
-        fromIter = cameFrom_.find(fromIter->second);
+    if (visited(iDest_)) {
+        for (int i = iDest_; i != RandomMap::invalidIndex; i = cameFrom_[i]) {
+            path.push_back(rmap_->hexFromInt(i));
+        }
+    }
+    std::ranges::reverse(path);
+
+    return path;
+}
+
+template <typename Queue>
+void BasicPathfinder<Queue>::find_reachable(const GameObject &mover,
+                                            int movesLeft,
+                                            const EnumSizedArray<int, Terrain> &tileCost)
+{
+    assert(movesLeft >= 0);
+    if (mover.entity == reachEntity_ &&
+        mover.hex == reachSrc_ &&
+        movesLeft == reachMoves_ &&
+        game_->version() == reachVersion_ &&
+        tileCost == reachTileCost_)
+    {
+        return;
+    }
+
+    // Only the tiles the last flood reached need to be reset.
+    for (int index : reachTiles_) {
+        reachCost_[index] = -1;
+    }
+    reachTiles_.clear();
+    reachEntity_ = mover.entity;
+    reachSrc_ = mover.hex;
+    reachMoves_ = movesLeft;
+    reachVersion_ = game_->version();
+    reachTileCost_ = tileCost;
+
+    mover_ = &mover;
+    iSrc_ = rmap_->intFromHex(mover_->hex);
+    region_ = rmap_->getRegion(iSrc_);
+    update_tile_actions(mover);
+    reachCost_[iSrc_] = 0;
+    reachFrom_[iSrc_] = RandomMap::invalidIndex;
+
+    // Dijkstra's algorithm, there's no destination to aim for.  Stale queue
+    // entries are skipped instead of being removed.
+    frontier_.clear();
+    frontier_.push({iSrc_, 0});
+    while (!frontier_.empty()) {
+        const auto current = frontier_.pop();
+        if (current.cost > reachCost_[current.index]) {
+            continue;
+        }
+
+        for (int iNbr : rmap_->getTileNeighbors(current.index)) {
+            flood_relax(iNbr, current.index, current.cost);
+        }
+    }
+
+    // The mover is already on the starting tile, it's not somewhere to go.
+    reachCost_[iSrc_] = -1;
+}
+
+template <typename Queue>
+Path BasicPathfinder<Queue>::reachable_path(const Hex &hDest) const
+{
+    Path path;
+    if (rmap_->offGrid(hDest) || reachable_cost(hDest) < 0) {
+        return path;
+    }
+
+    for (int i = rmap_->intFromHex(hDest); i != RandomMap::invalidIndex; i = reachFrom_[i]) {
+        path.push_back(rmap_->hexFromInt(i));
     }
     std::ranges::reverse(path);
 
     return path;
 }
 
-Neighbors<int> Pathfinder::get_neighbors(int index) const
+template <typename Queue>
+int BasicPathfinder<Queue>::reachable_cost(const Hex &hDest) const
+{
+    if (rmap_->offGrid(hDest)) {
+        return -1;
+    }
+    return reachCost_[rmap_->intFromHex(hDest)];
+}
+
+template <typename Queue>
+const std::vector<int> & BasicPathfinder<Queue>::reachable_tiles() const
+{
+    return reachTiles_;
+}
+
+template <typename Queue>
+void BasicPathfinder<Queue>::update_tile_actions(const GameObject &mover)
+{
+    const bool onWater = rmap_->getTerrain(mover.hex) == Terrain::water;
+    if (curActions_ > 0 &&
+        mover.entity == actionsEntity_ &&
+        mover.team == actionsTeam_ &&
+        onWater == actionsOnWater_ &&
+        game_->version() == actionsVersion_)
+    {
+        return;
+    }
+
+    if (++curActions_ == 0) {
+        std::ranges::fill(tileActions_, TileAction());
+        curActions_ = 1;
+    }
+    actionsEntity_ = mover.entity;
+    actionsTeam_ = mover.team;
+    actionsOnWater_ = onWater;
+    actionsVersion_ = game_->version();
+}
+
+template <typename Queue>
+auto BasicPathfinder<Queue>::tile_action(int index) -> TileAction
+{
+    auto &tile = tileActions_[index];
+    if (tile.stamp != curActions_) {
+        auto [action, obj] = game_->hex_action(*mover_, rmap_->hexFromInt(index));
+        tile = {action, obj.entity, curActions_};
+    }
+    return tile;
+}
+
+template <typename Queue>
+Neighbors<int> BasicPathfinder<Queue>::get_neighbors(int index)
 {
     Neighbors<int> iNbrs;
     assert(!rmap_->offGrid(index));
@@ -120,9 +268,8 @@ Neighbors<int> Pathfinder::get_neighbors(int index) const
     for (auto i = 0u; i < hNbrs.size(); ++i) {
         iNbrs[i] = rmap_->intFromHex(hNbrs[i]);
 
-        auto prevIter = cameFrom_.find(index);
-        if (prevIter != std::end(cameFrom_)) {
-            int iPrev = prevIter->second;
+        if (visited(index)) {
+            int iPrev = cameFrom_[index];
 
             // Every step has a nonzero cost so we'll never step back to the tile
             // we just came from.
@@ -148,7 +295,8 @@ Neighbors<int> Pathfinder::get_neighbors(int index) const
     return iNbrs;
 }
 
-bool Pathfinder::is_reachable(int index) const
+template <typename Queue>
+bool BasicPathfinder<Queue>::is_reachable(int index)
 {
     if (!rmap_->getWalkable(index)) {
         return false;
@@ -161,8 +309,7 @@ bool Pathfinder::is_reachable(int index) const
 
     auto srcTerrain = rmap_->getTerrain(iSrc_);
     auto terrain = rmap_->getTerrain(index);
-    auto hex = rmap_->hexFromInt(index);
-    auto [action, obj] = game_->hex_action(*mover_, hex);
+    auto [action, entity, _] = tile_action(index);
 
     // If you started on land, you can't step onto water unless you're boarding a
     // boat.
@@ -186,7 +333,7 @@ bool Pathfinder::is_reachable(int index) const
     // hex (either within that army's ZoC or empty).  And then, only if we're
     // stopping there, or continuing on to that army's hex.
     if (action == ObjectAction::battle) {
-        if (obj.entity == destObject_.entity &&
+        if (entity == destObject_.entity &&
             (index == iDest_ || hDest_ == destObject_.hex))
         {
             return true;
@@ -204,3 +351,101 @@ bool Pathfinder::is_reachable(int index) const
 
     return true;
 }
+
+// These follow the same rules as is_reachable(), but without knowing the
+// destination in advance.
+template <typename Queue>
+auto BasicPathfinder<Queue>::flood_step(int index) -> Step
+{
+    if (!rmap_->getWalkable(index)) {
+        return Step::blocked;
+    }
+
+    auto [action, entity, _] = tile_action(index);
+
+    // Crossing the coastline means boarding or leaving a boat, and that ends
+    // the move.
+    const bool srcWater = rmap_->getTerrain(iSrc_) == Terrain::water;
+    const bool water = rmap_->getTerrain(index) == Terrain::water;
+    if (srcWater != water) {
+        if ((!srcWater && action == ObjectAction::embark) ||
+            (srcWater && action == ObjectAction::disembark))
+        {
+            return Step::stop;
+        }
+        return Step::blocked;
+    }
+
+    // Leaving the current region uses up all your movement.
+    if (rmap_->getRegion(index) != region_) {
+        return Step::stop;
+    }
+
+    // Only the army's own hex ends the move, the rest of its zone of control
+    // leads to it.
+    if (action == ObjectAction::battle &&
+        game_->get_object(entity).hex != rmap_->hexFromInt(index))
+    {
+        return Step::zoc;
+    }
+    else if (action != ObjectAction::none) {
+        return Step::stop;
+    }
+
+    return Step::pass;
+}
+
+template <typename Queue>
+void BasicPathfinder<Queue>::flood_relax(int index, int from, int cost)
+{
+    if (rmap_->offGrid(index)) {
+        return;
+    }
+
+    const int newCost = cost + reachTileCost_[rmap_->getTerrain(index)];
+    if (newCost > reachMoves_ ||
+        (reachCost_[index] >= 0 && newCost >= reachCost_[index]))
+    {
+        return;
+    }
+
+    const auto step = flood_step(index);
+    if (step == Step::blocked) {
+        return;
+    }
+
+    if (reachCost_[index] < 0) {
+        reachTiles_.push_back(index);
+    }
+    reachCost_[index] = newCost;
+    reachFrom_[index] = from;
+
+    if (step == Step::pass) {
+        frontier_.push({index, newCost});
+    }
+    else if (step == Step::zoc) {
+        // The only way forward is to attack the army whose zone of control
+        // this is.  Wandering further inside the zone first is allowed by
+        // is_reachable() but it's never cheaper than going straight there.
+        const auto hArmy = game_->get_object(tile_action(index).entity).hex;
+        flood_relax(rmap_->intFromHex(hArmy), index, newCost);
+    }
+}
+
+template <typename Queue>
+bool BasicPathfinder<Queue>::visited(int index) const
+{
+    return searchStamp_[index] == curSearch_;
+}
+
+template <typename Queue>
+void BasicPathfinder<Queue>::visit(int index, int from, int cost)
+{
+    searchStamp_[index] = curSearch_;
+    cameFrom_[index] = from;
+    costSoFar_[index] = cost;
+}
+
+
+template class BasicPathfinder<BucketQueue<EstimatedPathCost>>;
+template class BasicPathfinder<BinaryHeap<EstimatedPathCost>>;
@@ -1,5 +1,5 @@
 /*
-    Copyright (C) 2016-2020 by Michael Kristofik <kristo605@gmail.com>
+    Copyright (C) 2016-2025 by Michael Kristofik <kristo605@gmail.com>
     Part of the Champions of Anduran project.
  
     This program is free software; you can redistribute it and/or modify
@@ -17,8 +17,9 @@
 #include "PriorityQueue.h"
 #include "hex_utils.h"
 #include "team_color.h"
+#include "terrain.h"
 
-#include "boost/container/flat_map.hpp"
+#include <vector>
 
 class RandomMap;
 
@@ -32,20 +33,73 @@ bool operator>(const EstimatedPathCost &lhs, const EstimatedPathCost &rhs);
 
 
 // Each thread should have its own one of these due to internal state.
-class Pathfinder
+//
+// The frontier can be any of the queues in PriorityQueue.h that pops in order
+// of estimated path cost.  Path costs are small integers that never go down
+// during a search, so the bucket queue is the default.  Only the two queue types
+// named below are compiled in.
+template <typename Queue>
+class BasicPathfinder
 {
 public:
-    Pathfinder(const RandomMap &rmap, const GameState &state);
+    BasicPathfinder(const RandomMap &rmap, const GameState &state);
 
     Path find_path(const GameObject &mover, const Hex &hDest);
 
+    // Flood outward from the mover to every tile it could end its move on this
+    // turn, paying tileCost for each tile entered.  The result is kept until the
+    // mover, its movement, or the game state changes, so calling this again on
+    // every mouse move is nearly free.
+    void find_reachable(const GameObject &mover,
+                        int movesLeft,
+                        const EnumSizedArray<int, Terrain> &tileCost);
+
+    // Cheapest path found by the last flood, or empty if the mover can't get
+    // there this turn.
+    Path reachable_path(const Hex &hDest) const;
+
+    // Movement needed to get there, or -1 if it can't.
+    int reachable_cost(const Hex &hDest) const;
+
+    // Every tile found by the last flood, not counting where the mover started.
+    const std::vector<int> & reachable_tiles() const;
+
 private:
-    Neighbors<int> get_neighbors(int index) const;
-    bool is_reachable(int index) const;
+    // What the mover would do on each tile, the compact parts of GameAction.
+    // GameState::hex_action() is only asked the first time a search needs a
+    // tile, after that it's read straight from the array until the mover or
+    // the game state changes.
+    struct TileAction
+    {
+        ObjectAction action = ObjectAction::none;
+        int entity = -1;
+        unsigned int stamp = 0;
+    };
+    void update_tile_actions(const GameObject &mover);
+    TileAction tile_action(int index);
+
+    Neighbors<int> get_neighbors(int index);
+    bool is_reachable(int index);
 
-    boost::container::flat_map<int, int> cameFrom_;
-    boost::container::flat_map<int, int> costSoFar_;
-    PriorityQueue<EstimatedPathCost> frontier_;
+    // How the flood is allowed to enter a tile.  Moves end on 'stop' tiles, and
+    // from a 'zoc' tile the only way forward is to attack the army controlling
+    // it.
+    enum class Step {blocked, pass, stop, zoc};
+    Step flood_step(int index);
+    void flood_relax(int index, int from, int cost);
+
+    // Has the current search reached this tile yet?
+    bool visited(int index) const;
+    void visit(int index, int from, int cost);
+
+    // Search state for every tile on the map.  A tile's entries only count if
+    // its stamp matches the current search, so starting a new search doesn't
+    // have to clear anything.
+    std::vector<int> cameFrom_;
+    std::vector<int> costSoFar_;
+    std::vector<unsigned int> searchStamp_;
+    unsigned int curSearch_;
+    Queue frontier_;
     const RandomMap *rmap_;
     const GameState *game_;
     const GameObject *mover_;
@@ -54,6 +108,28 @@ private:
     int iDest_;
     Hex hDest_;
     GameObject destObject_;
+
+    // Tile actions are stamped like the search state is.  The mover's
+    // position only matters for whether it's on a boat.
+    std::vector<TileAction> tileActions_;
+    unsigned int curActions_;
+    int actionsEntity_;
+    Team actionsTeam_;
+    bool actionsOnWater_;
+    unsigned int actionsVersion_;
+
+    // Results of the last flood and what it was computed from.
+    std::vector<int> reachCost_;
+    std::vector<int> reachFrom_;
+    std::vector<int> reachTiles_;
+    EnumSizedArray<int, Terrain> reachTileCost_;
+    int reachEntity_;
+    Hex reachSrc_;
+    int reachMoves_;
+    unsigned int reachVersion_;
 };
 
+using Pathfinder = BasicPathfinder<BucketQueue<EstimatedPathCost>>;
+using HeapPathfinder = BasicPathfinder<BinaryHeap<EstimatedPathCost>>;
+
 #endif
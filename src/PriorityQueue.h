@@ -1,5 +1,5 @@
 /*
-    Copyright (C) 2019 by Michael Kristofik <kristo605@gmail.com>
+    Copyright (C) 2019-2025 by Michael Kristofik <kristo605@gmail.com>
     Part of the Champions of Anduran project.
  
     This program is free software; you can redistribute it and/or modify
@@ -18,8 +18,11 @@
 #include <functional>
 #include <vector>
 
-// Improvements over std::priority_queue: lazy updates, clear(), and using a
-// min-heap.
+// Three min-priority queues with the same interface.  Each one has clear()
+// (which keeps its memory for reuse), unlike std::priority_queue.
+
+// Lazy updates: pushes are O(1), and the first pop after any push rebuilds the
+// whole heap.  Best when all the pushes come before all the pops.
 //
 // requires: T is GreaterThanComparable
 template <typename T>
@@ -39,6 +42,52 @@ private:
 };
 
 
+// Binary heap updated on every push.  Push and pop are both O(log n), which is
+// better when they're interleaved, as in Dijkstra's algorithm or A*.
+//
+// requires: T is GreaterThanComparable
+template <typename T>
+class BinaryHeap
+{
+public:
+    BinaryHeap();
+
+    void push(const T &elem);
+    T pop();
+    void clear();
+    bool empty() const;
+
+private:
+    std::vector<T> q_;
+};
+
+
+// Bucket queue (Dial's algorithm) for small, non-negative integer priorities,
+// given by the member 'Key' (for example, a path cost).  Push and pop are O(1),
+// plus one step for each empty bucket skipped over.  Elements with equal
+// priority come out last in, first out.
+//
+// Only works if priorities never go down: nothing pushed can have a lower
+// priority than the last element popped.  That's true for Dijkstra's
+// algorithm, and for A* with a consistent heuristic.
+template <typename T, auto Key = &T::cost>
+class BucketQueue
+{
+public:
+    BucketQueue();
+
+    void push(const T &elem);
+    T pop();
+    void clear();
+    bool empty() const;
+
+private:
+    std::vector<std::vector<T>> buckets_;  // indexed by priority
+    int cur_;  // no lower bucket has anything in it
+    int size_;
+};
+
+
 template <typename T>
 PriorityQueue<T>::PriorityQueue()
     : q_(),
@@ -82,4 +131,95 @@ bool PriorityQueue<T>::empty() const
     return q_.empty();
 }
 
+
+
+template <typename T>
+BinaryHeap<T>::BinaryHeap()
+    : q_()
+{
+}
+
+template <typename T>
+void BinaryHeap<T>::push(const T &elem)
+{
+    q_.push_back(elem);
+    std::ranges::push_heap(q_, std::greater<T>());
+}
+
+template <typename T>
+T BinaryHeap<T>::pop()
+{
+    assert(!empty());
+
+    auto elem = q_.front();
+    std::ranges::pop_heap(q_, std::greater<T>());
+    q_.pop_back();
+    return elem;
+}
+
+template <typename T>
+void BinaryHeap<T>::clear()
+{
+    q_.clear();
+}
+
+template <typename T>
+bool BinaryHeap<T>::empty() const
+{
+    return q_.empty();
+}
+
+
+template <typename T, auto Key>
+BucketQueue<T, Key>::BucketQueue()
+    : buckets_(),
+    cur_(0),
+    size_(0)
+{
+}
+
+template <typename T, auto Key>
+void BucketQueue<T, Key>::push(const T &elem)
+{
+    const int key = std::invoke(Key, elem);
+    assert(key >= cur_);
+
+    if (key >= std::ssize(buckets_)) {
+        buckets_.resize(key + 1);
+    }
+    buckets_[key].push_back(elem);
+    ++size_;
+}
+
+template <typename T, auto Key>
+T BucketQueue<T, Key>::pop()
+{
+    assert(!empty());
+
+    while (buckets_[cur_].empty()) {
+        ++cur_;
+    }
+    auto elem = buckets_[cur_].back();
+    buckets_[cur_].pop_back();
+    --size_;
+    return elem;
+}
+
+template <typename T, auto Key>
+void BucketQueue<T, Key>::clear()
+{
+    // Everything below the current bucket is already empty.
+    for (int i = cur_; i < std::ssize(buckets_); ++i) {
+        buckets_[i].clear();
+    }
+    cur_ = 0;
+    size_ = 0;
+}
+
+template <typename T, auto Key>
+bool BucketQueue<T, Key>::empty() const
+{
+    return size_ == 0;
+}
+
 #endif
@@ -16,6 +16,7 @@
 
 #include <algorithm>
 #include <cassert>
+#include <thread>
 
 PuzzleState::PuzzleState(RandomMap &rmap)
     : targetHexes_(),
@@ -26,11 +27,10 @@ PuzzleState::PuzzleState(RandomMap &rmap)
     // obelisk on each play of the same map.
     auto ordering = random_enum_array<PuzzleType, PuzzleType>();
 
-    // Copying hexes to vector here is required because hexCluster() needs random
-    // access to the elements.
     auto hexView = rmap.getObjectHexes(ObjectType::obelisk);
     std::vector<Hex> hexes(hexView.begin(), hexView.end());
-    auto obelisks = hexClusters(hexes, enum_size<PuzzleType>());
+    auto obelisks = hexClusters(hexes, enum_size<PuzzleType>(),
+                                std::thread::hardware_concurrency());
 
     for (int i = 0; i < ssize(hexes); ++i) {
         int tile = rmap.intFromHex(hexes[i]);
@@ -1,5 +1,5 @@
 /*
-    Copyright (C) 2016-2024 by Michael Kristofik <kristo605@gmail.com>
+    Copyright (C) 2016-2025 by Michael Kristofik <kristo605@gmail.com>
     Part of the Champions of Anduran project.
 
     This program is free software; you can redistribute it and/or modify
@@ -11,34 +11,202 @@
     See the COPYING.txt file for more details.
 */
 #include "RandomMap.h"
+#include "DisjointSets.h"
+#include "Noise.h"
 #include "RandomRange.h"
+#include "binary_utils.h"
 #include "container_utils.h"
 #include "json_utils.h"
-#include "open-simplex-noise.h"
+#include "map_file_format.h"
+#include "thread_utils.h"
 
-#include "boost/container/flat_map.hpp"
 #include "boost/container/flat_set.hpp"
 #include "rapidjson/document.h"
 
 #include <algorithm>
 #include <cassert>
 #include <cmath>
-#include <ctime>
+#include <deque>
+#include <format>
 #include <functional>
 #include <iterator>
 #include <memory>
 #include <numeric>
 #include <queue>
+#include <span>
+#include <sstream>
 #include <string>
+#include <string_view>
 #include <stdexcept>
 #include <tuple>
 
 namespace
 {
-    const int REGION_SIZE = 64;
-    const int MAX_ALTITUDE = 3;
-    const double NOISE_FEATURE_SIZE = 2.0;
-    const double OBSTACLE_LEVEL = 0.2;
+    // Generation checkpoints use the same container and section numbers as
+    // map files.
+    const BinaryMagic CHECKPOINT_MAGIC = {'A', 'N', 'D', 'U', 'R', 'C', 'K', 'P'};
+    const uint32_t CHECKPOINT_VERSION = 1;
+
+    using MapSection = MapFile::Section;
+    using enum MapFile::Section;
+
+    // Map files and checkpoints might be cut short or corrupted on disk.  Check
+    // anything we'd use as an index before trusting it.
+    [[noreturn]] void throw_corrupt(const char *filename, std::string_view what)
+    {
+        throw std::runtime_error(std::format("{}: {}", filename, what));
+    }
+
+    void check_indexes(std::span<const int> values,
+                       int limit,
+                       const char *filename,
+                       std::string_view what)
+    {
+        if (!std::ranges::all_of(values, [limit] (int v) { return v >= 0 && v < limit; })) {
+            throw_corrupt(filename, std::format("{} out of range", what));
+        }
+    }
+
+    // Offsets must start at zero, never go down, and end within the section
+    // they point into.
+    void check_offsets(std::span<const int> offsets,
+                       size_t numElems,
+                       const char *filename,
+                       std::string_view what)
+    {
+        if (offsets.empty() ||
+            offsets.front() != 0 ||
+            std::ranges::adjacent_find(offsets, std::greater{}) != std::end(offsets) ||
+            static_cast<size_t>(offsets.back()) > numElems)
+        {
+            throw_corrupt(filename, std::format("{} out of range", what));
+        }
+    }
+
+    template <BinaryElement T>
+    void copy_section(const BinaryFileReader &file, MapSection id, std::vector<T> &outVec)
+    {
+        auto elems = file.section<T>(id);
+        outVec.assign(std::begin(elems), std::end(elems));
+    }
+
+    // Return the map width, which has to be the square root of the number of
+    // tiles.
+    int copy_tile_regions(const BinaryFileReader &file,
+                          const char *filename,
+                          std::vector<int> &outVec)
+    {
+        copy_section(file, tileRegions, outVec);
+        const int width = std::sqrt(outVec.size());
+        if (outVec.empty() || static_cast<size_t>(width) * width != outVec.size()) {
+            throw_corrupt(filename, "map isn't square");
+        }
+        return width;
+    }
+
+    TileBitset read_bits(const BinaryFileReader &file,
+                         MapSection id,
+                         int size,
+                         const char *filename)
+    {
+        auto words = file.section<uint64_t>(id);
+        if (ssize(words) != (size + 63) / 64) {
+            throw_corrupt(filename, std::format("section {} has the wrong size", id));
+        }
+        return TileBitset(size, words);
+    }
+
+    // Distance in regions to the nearest castle, -1 if there isn't one.
+    void check_castle_distances(std::span<const int> dist,
+                                int numRegions,
+                                const char *filename)
+    {
+        if (ssize(dist) != numRegions) {
+            throw_corrupt(filename, "wrong number of castle distances");
+        }
+        for (int d : dist) {
+            if (d < -1 || d >= numRegions) {
+                throw_corrupt(filename, "castle distance out of range");
+            }
+        }
+    }
+
+    // Terrain types and pairs of ints are stored as plain int arrays.
+    void add_terrain(BinaryFileWriter &file, MapSection id, std::span<const Terrain> terrain)
+    {
+        std::vector<int> values;
+        std::ranges::transform(terrain, std::back_inserter(values),
+                               [] (Terrain t) { return static_cast<int>(t); });
+        file.addSection(id, std::span<const int>(values));
+    }
+
+    void copy_terrain(const BinaryFileReader &file,
+                      MapSection id,
+                      const char *filename,
+                      std::vector<Terrain> &outVec)
+    {
+        auto values = file.section<int>(id);
+        check_indexes(values, enum_size<Terrain>(), filename, "terrain");
+        if (values.empty()) {
+            throw_corrupt(filename, "no regions");
+        }
+        for (int t : values) {
+            outVec.push_back(static_cast<Terrain>(t));
+        }
+    }
+
+    void add_pairs(BinaryFileWriter &file,
+                   MapSection id,
+                   std::span<const std::pair<int, int>> pairs)
+    {
+        std::vector<int> values;
+        values.reserve(pairs.size() * 2);
+        for (auto [first, second] : pairs) {
+            values.push_back(first);
+            values.push_back(second);
+        }
+        file.addSection(id, std::span<const int>(values));
+    }
+
+    std::vector<std::pair<int, int>> read_pairs(const BinaryFileReader &file,
+                                                MapSection id,
+                                                const char *filename)
+    {
+        auto values = file.section<int>(id);
+        if (values.size() % 2 != 0) {
+            throw_corrupt(filename, std::format("section {} has the wrong size", id));
+        }
+
+        std::vector<std::pair<int, int>> pairs;
+        pairs.reserve(values.size() / 2);
+        for (size_t i = 0; i + 1 < values.size(); i += 2) {
+            pairs.emplace_back(values[i], values[i + 1]);
+        }
+        return pairs;
+    }
+
+    // Keys and values are both indexes, each with its own limit.
+    void copy_multimap(const BinaryFileReader &file,
+                       MapSection id,
+                       int numKeys,
+                       int numValues,
+                       const char *filename,
+                       FlatMultimap<int, int> &fmm)
+    {
+        using KeyValue = FlatMultimap<int, int>::KeyValue;
+        auto data = file.section<KeyValue>(id);
+        if (std::ranges::adjacent_find(data, std::greater_equal{}) != std::end(data)) {
+            throw_corrupt(filename, std::format("section {} isn't sorted", id));
+        }
+        for (auto &[key, value] : data) {
+            if (key < 0 || key >= numKeys || value < 0 || value >= numValues) {
+                throw_corrupt(filename, std::format("section {} out of range", id));
+            }
+        }
+
+        fmm.assignSorted(data);
+        fmm.freeze();
+    }
 
     auto getCastleHexes(const Hex &startHex)
     {
@@ -91,37 +259,6 @@ struct RandomHex
 };
 
 
-// RAII wrapper around the Open Simplex Noise library in C.
-class Noise
-{
-public:
-    Noise();
-
-    // Generate a value in the range [-1.0, 1.0] for the given coordinates.
-    double get(int x, int y);
-private:
-    std::shared_ptr<osn_context> ctx_;
-};
-
-Noise::Noise()
-    : ctx_()
-{
-    osn_context *tmp = nullptr;
-    open_simplex_noise(std::time(nullptr), &tmp);
-    ctx_.reset(tmp, open_simplex_noise_free);
-}
-
-double Noise::get(int x, int y)
-{
-    // Stole the feature size concept from open-simplex-noise-test.c. I don't
-    // know what it means but it seems to smooth out the noise values over a
-    // range of coordinates.
-    return open_simplex_noise2(ctx_.get(),
-                               x / NOISE_FEATURE_SIZE,
-                               y / NOISE_FEATURE_SIZE);
-}
-
-
 Coastline::Coastline(const std::pair<int, int> landmassPair)
     : landmasses(landmassPair)
 {
@@ -133,15 +270,20 @@ bool operator==(const Coastline &lhs, const std::pair<int, int> &rhs)
 }
 
 
-RandomMap::RandomMap(int width, const ObjectManager &objMgr)
+RandomMap::RandomMap(int width,
+                     unsigned int seed,
+                     const ObjectManager &objMgr,
+                     int numThreads,
+                     const StageCallback &onStageDone)
     : width_(width),
     size_(width_ * width_),
     numRegions_(0),
+    numThreads_(std::max(numThreads, 1)),
+    seed_(seed),
     tileRegions_(size_, invalidIndex),
-    tileNeighbors_(),
-    tileObstacles_(size_, 0),
-    tileOccupied_(size_, 0),
-    tileWalkable_(size_, 1),
+    tileObstacles_(size_),
+    tileOccupied_(size_),
+    tileWalkable_(size_, true),
     borderTiles_(),
     tileRegionNeighbors_(),
     regionNeighbors_(),
@@ -152,28 +294,52 @@ RandomMap::RandomMap(int width, const ObjectManager &objMgr)
     castles_(),
     castleRegions_(),
     regionCastleDistance_(),
-    villageNeighbors_(size_, 0),
-    coastalObjectNeighbors_(size_, 0),
+    villageNeighbors_(size_),
+    coastalObjectNeighbors_(size_),
+    tilePool_(),
+    tilePoolPos_(),
+    regionPoolStart_(),
+    regionPoolSize_(),
     objectTiles_(),
-    objectMgr_(&objMgr)
-{
-    generateRegions();
-    buildNeighborGraphs();
-    assignTerrain();
-    computeLandmasses();
-    placeCastles();
-    placeVillages();
-    placeObjects();
-    assignObstacles();
-    placeArmies();
+    tileObjectDistance_(),
+    regionObjectDistance_(),
+    objectMgr_(&objMgr),
+    profile_(),
+    stage_(),
+    stageEngine_()
+{
+    // Every random choice made while generating comes from this seed.
+    ScopedRandomSeed scopedSeed(seed_);
+    runStages({}, onStageDone);
 }
 
 RandomMap::RandomMap(const char *filename, const ObjectManager &objMgr)
+    : RandomMap(objMgr, 1)
+{
+    if (BinaryFileReader::matches(filename, MapFile::magic)) {
+        readBinaryFile(filename);
+    }
+    else {
+        readJsonFile(filename);
+    }
+
+    for (auto i : castles_) {
+        castleRegions_.push_back(tileRegions_[i]);
+    }
+
+    // Older map files don't include this, but it's cheap to recompute.
+    if (regionCastleDistance_.empty()) {
+        computeCastleDistance();
+    }
+}
+
+RandomMap::RandomMap(const ObjectManager &objMgr, int numThreads)
     : width_(0),
     size_(0),
     numRegions_(0),
+    numThreads_(std::max(numThreads, 1)),
+    seed_(0),
     tileRegions_(),
-    tileNeighbors_(),
     tileObstacles_(),
     tileOccupied_(),
     tileWalkable_(),
@@ -186,34 +352,161 @@ RandomMap::RandomMap(const char *filename, const ObjectManager &objMgr)
     coastlines_(),
     castles_(),
     castleRegions_(),
+    regionCastleDistance_(),
     villageNeighbors_(),
     coastalObjectNeighbors_(),
+    tilePool_(),
+    tilePoolPos_(),
+    regionPoolStart_(),
+    regionPoolSize_(),
     objectTiles_(),
-    objectMgr_(&objMgr)
+    tileObjectDistance_(),
+    regionObjectDistance_(),
+    objectMgr_(&objMgr),
+    profile_(),
+    stage_(),
+    stageEngine_()
+{
+}
+
+RandomMap RandomMap::resume(const char *checkpoint,
+                            const ObjectManager &objMgr,
+                            std::optional<unsigned int> rerollSeed,
+                            int numThreads,
+                            const StageCallback &onStageDone)
 {
-    auto doc = jsonReadFile(filename);
+    RandomMap rmap(objMgr, numThreads);
+    rmap.readCheckpoint(checkpoint);
+
+    // Carry on with the same random numbers the full run would have used,
+    // unless we're rerolling.
+    ScopedRandomSeed scopedSeed(rerollSeed.value_or(rmap.seed_));
+    if (!rerollSeed) {
+        RandomRange::engine = rmap.stageEngine_;
+    }
+    rmap.runStages(rmap.stage_, onStageDone);
 
-    jsonGetArray(doc, "tile-regions", tileRegions_);
-    jsonGetArray(doc, "region-terrain", regionTerrain_);
-    jsonGetArray(doc, "tile-obstacles", tileObstacles_);
-    jsonGetArray(doc, "tile-occupied", tileOccupied_);
-    jsonGetArray(doc, "tile-walkable", tileWalkable_);
-    jsonGetArray(doc, "castles", castles_);
-    jsonGetArray(doc, "region-castle-distance", regionCastleDistance_);
+    return rmap;
+}
+
+void RandomMap::runStages(std::optional<MapStage> lastDone,
+                          const StageCallback &onStageDone)
+{
+    for (auto stage : MapStage()) {
+        if (lastDone && stage <= *lastDone) {
+            continue;
+        }
+
+        switch (stage) {
+            case MapStage::regions:
+                profile_.run("generateRegions", [this] { generateRegions(); });
+                profile_.run("buildNeighborGraphs", [this] { buildNeighborGraphs(); });
+                profile_.run("assignTerrain", [this] { assignTerrain(); });
+                break;
+            case MapStage::castles:
+                profile_.run("computeLandmasses", [this] { computeLandmasses(); });
+                profile_.run("placeCastles", [this] { placeCastles(); });
+                break;
+            case MapStage::objects:
+                profile_.run("placeVillages", [this] { placeVillages(); });
+                profile_.run("placeObjects", [this] { placeObjects(); });
+                profile_.run("assignObstacles", [this] { assignObstacles(); });
+                profile_.run("placeArmies", [this] { placeArmies(); });
+                break;
+            default:
+                assert(false);
+                break;
+        }
+
+        stage_ = stage;
+        stageEngine_ = RandomRange::engine;
+        if (onStageDone) {
+            onStageDone(*this, stage);
+        }
+    }
+}
+
+void RandomMap::readJsonFile(const char *filename)
+{
+    // Map files are big, stream the arrays straight into place rather than
+    // building a document first.  All map objects live in the aptly-named
+    // "objects" sub-object.  Each member is an array of tile indexes.
+    std::vector<signed char> obstacles;
+    std::vector<signed char> occupied;
+    std::vector<signed char> walkable;
+
+    JsonArrayReader reader;
+    reader.addArray("tile-regions", tileRegions_);
+    reader.addArray("region-terrain", regionTerrain_);
+    reader.addArray("tile-obstacles", obstacles, tileRegions_);
+    reader.addArray("tile-occupied", occupied, tileRegions_);
+    reader.addArray("tile-walkable", walkable, tileRegions_);
+    reader.addArray("castles", castles_);
+    reader.addArray("region-castle-distance", regionCastleDistance_, regionTerrain_);
+    reader.addMultimap("objects", objectTiles_);
+    reader.read(filename);
+
+    tileObstacles_ = TileBitset(obstacles);
+    tileOccupied_ = TileBitset(occupied);
+    tileWalkable_ = TileBitset(walkable);
     size_ = tileRegions_.size();
     width_ = std::sqrt(size_);
     numRegions_ = regionTerrain_.size();
 
-    // All map objects live in the aptly-named sub-object below. Each member is
-    // an array of tile indexes.
-    jsonGetMultimap(doc, "objects", objectTiles_);
+    mapRegionsToTiles();
+    buildNeighborGraphs();
+}
 
-    for (auto i : castles_) {
-        castleRegions_.push_back(tileRegions_[i]);
+void RandomMap::readBinaryFile(const char *filename)
+{
+    BinaryFileReader file(filename, MapFile::magic, MapFile::version);
+
+    width_ = copy_tile_regions(file, filename, tileRegions_);
+    size_ = tileRegions_.size();
+
+    copy_terrain(file, regionTerrain, filename, regionTerrain_);
+    numRegions_ = regionTerrain_.size();
+    check_indexes(tileRegions_, numRegions_, filename, "tile regions");
+
+    tileObstacles_ = read_bits(file, tileObstacles, size_, filename);
+    tileOccupied_ = read_bits(file, tileOccupied, size_, filename);
+    tileWalkable_ = read_bits(file, tileWalkable, size_, filename);
+    copy_section(file, castles, castles_);
+    check_indexes(castles_, size_, filename, "castles");
+
+    // Older map files don't include castle distances, we recompute them after
+    // loading.  Unreachable regions are -1.
+    copy_section(file, regionCastleDistance, regionCastleDistance_);
+    if (!regionCastleDistance_.empty()) {
+        check_castle_distances(regionCastleDistance_, numRegions_, filename);
+    }
+
+    auto objOffsets = file.section<int>(objectOffsets);
+    auto objTiles = file.section<int>(objectTiles);
+    if (ssize(objOffsets) != enum_size<ObjectType>() + 1) {
+        throw_corrupt(filename, "wrong number of object types");
+    }
+    check_offsets(objOffsets, objTiles.size(), filename, "object offsets");
+    check_indexes(objTiles, size_, filename, "object tiles");
+    for (auto type : ObjectType()) {
+        auto name = std::string(str_from_ObjectType(type));
+        const int t = static_cast<int>(type);
+        for (int i = objOffsets[t]; i < objOffsets[t + 1]; ++i) {
+            objectTiles_.insert(name, objTiles[i]);
+        }
     }
 
+    // The border tile list only matters while generating a map.
+    copy_multimap(file, tileRegionNeighbors, size_, numRegions_, filename,
+                  tileRegionNeighbors_);
+    copy_multimap(file, regionNeighbors, numRegions_, numRegions_, filename,
+                  regionNeighbors_);
     mapRegionsToTiles();
-    buildNeighborGraphs();
+
+    // Maps generated a band at a time don't include the neighbor graphs.
+    if (regionNeighbors_.size() == 0 && numRegions_ > 1) {
+        buildNeighborGraphs();
+    }
 }
 
 void RandomMap::writeFile(const char *filename)
@@ -222,14 +515,180 @@ void RandomMap::writeFile(const char *filename)
 
     jsonSetArray<int>(doc, "tile-regions", tileRegions_);
     jsonSetArray<int>(doc, "region-terrain", regionTerrain_);
-    jsonSetArray<int>(doc, "tile-obstacles", tileObstacles_);
-    jsonSetArray<int>(doc, "tile-occupied", tileOccupied_);
-    jsonSetArray<int>(doc, "tile-walkable", tileWalkable_);
+    jsonSetArray<int>(doc, "tile-obstacles", tileObstacles_.toVector());
+    jsonSetArray<int>(doc, "tile-occupied", tileOccupied_.toVector());
+    jsonSetArray<int>(doc, "tile-walkable", tileWalkable_.toVector());
     jsonSetArray<int>(doc, "castles", castles_);
     jsonSetArray<int>(doc, "region-castle-distance", regionCastleDistance_);
     jsonSetMultimap(doc, "objects", objectTiles_);
 
-    jsonWriteFile(filename, doc);
+    jsonWriteFile(filename, doc, JsonFormat::compact);
+}
+
+void RandomMap::writeBinaryFile(const char *filename)
+{
+    BinaryFileWriter file(MapFile::magic, MapFile::version);
+
+    file.addSection(tileRegions, std::span<const int>(tileRegions_));
+    add_terrain(file, regionTerrain, regionTerrain_);
+    file.addSection(tileObstacles, tileObstacles_.words());
+    file.addSection(tileOccupied, tileOccupied_.words());
+    file.addSection(tileWalkable, tileWalkable_.words());
+    file.addSection(castles, std::span<const int>(castles_));
+    file.addSection(regionCastleDistance, std::span<const int>(regionCastleDistance_));
+
+    std::vector<int> objOffsets = {0};
+    std::vector<int> objTiles;
+    for (auto type : ObjectType()) {
+        for (int tile : getObjectTiles(type)) {
+            objTiles.push_back(tile);
+        }
+        objOffsets.push_back(ssize(objTiles));
+    }
+    file.addSection(objectOffsets, std::span<const int>(objOffsets));
+    file.addSection(objectTiles, std::span<const int>(objTiles));
+
+    file.addSection(tileRegionNeighbors, tileRegionNeighbors_.frozenData());
+    file.addSection(regionNeighbors, regionNeighbors_.frozenData());
+
+    file.write(filename);
+}
+
+void RandomMap::writeCheckpoint(const char *filename) const
+{
+    // After the last stage there's nothing left to resume, save the map
+    // instead.
+    if (!stage_ || *stage_ == MapStage::objects) {
+        throw std::runtime_error("no generation stages left to checkpoint");
+    }
+
+    BinaryFileWriter file(CHECKPOINT_MAGIC, CHECKPOINT_VERSION);
+
+    const uint32_t info[] = {static_cast<uint32_t>(*stage_), seed_};
+    file.addSection(stageInfo, std::span<const uint32_t>(info));
+    std::ostringstream engineText;
+    engineText << stageEngine_;
+    const auto text = engineText.str();
+    file.addSection(randomState, std::span<const char>(text));
+
+    // Output of the regions stage.  Border tiles are in random order, which
+    // the later stages depend on.
+    file.addSection(tileRegions, std::span<const int>(tileRegions_));
+    add_terrain(file, regionTerrain, regionTerrain_);
+    add_pairs(file, borderTiles, borderTiles_);
+    file.addSection(tileRegionNeighbors, tileRegionNeighbors_.frozenData());
+    file.addSection(regionNeighbors, regionNeighbors_.frozenData());
+
+    if (*stage_ >= MapStage::castles) {
+        file.addSection(regionLandmass, std::span<const int>(regionLandmass_));
+        file.addSection(castles, std::span<const int>(castles_));
+        file.addSection(regionCastleDistance, std::span<const int>(regionCastleDistance_));
+        file.addSection(tileOccupied, tileOccupied_.words());
+        file.addSection(tileWalkable, tileWalkable_.words());
+
+        std::vector<std::pair<int, int>> landmasses;
+        std::vector<uint32_t> terrain;
+        std::vector<int> offsets = {0};
+        std::vector<int> tiles;
+        for (auto &coast : coastlines_) {
+            landmasses.push_back(coast.landmasses);
+            terrain.push_back(coast.terrain.to_ulong());
+            tiles.insert(std::end(tiles), std::begin(coast.tiles), std::end(coast.tiles));
+            offsets.push_back(ssize(tiles));
+        }
+        add_pairs(file, coastLandmasses, landmasses);
+        file.addSection(coastTerrain, std::span<const uint32_t>(terrain));
+        file.addSection(coastTileOffsets, std::span<const int>(offsets));
+        file.addSection(coastTiles, std::span<const int>(tiles));
+    }
+
+    file.write(filename);
+}
+
+void RandomMap::readCheckpoint(const char *filename)
+{
+    BinaryFileReader file(filename, CHECKPOINT_MAGIC, CHECKPOINT_VERSION);
+
+    auto info = file.section<uint32_t>(stageInfo);
+    if (info.size() != 2 || info[0] >= static_cast<uint32_t>(MapStage::objects)) {
+        throw std::runtime_error(std::format("{}: not a valid checkpoint", filename));
+    }
+    stage_ = static_cast<MapStage>(info[0]);
+    seed_ = info[1];
+    auto text = file.section<char>(randomState);
+    std::istringstream engineText(std::string(std::begin(text), std::end(text)));
+    if (!(engineText >> stageEngine_)) {
+        throw_corrupt(filename, "bad random state");
+    }
+
+    width_ = copy_tile_regions(file, filename, tileRegions_);
+    size_ = tileRegions_.size();
+    copy_terrain(file, regionTerrain, filename, regionTerrain_);
+    numRegions_ = regionTerrain_.size();
+    check_indexes(tileRegions_, numRegions_, filename, "tile regions");
+    borderTiles_ = read_pairs(file, borderTiles, filename);
+    for (auto [tile, nbr] : borderTiles_) {
+        if (tile < 0 || tile >= size_ || nbr < 0 || nbr >= size_) {
+            throw_corrupt(filename, "border tiles out of range");
+        }
+    }
+    copy_multimap(file, tileRegionNeighbors, size_, numRegions_, filename,
+                  tileRegionNeighbors_);
+    copy_multimap(file, regionNeighbors, numRegions_, numRegions_, filename,
+                  regionNeighbors_);
+    mapRegionsToTiles();
+
+    tileObstacles_ = TileBitset(size_);
+    tileOccupied_ = TileBitset(size_);
+    tileWalkable_ = TileBitset(size_, true);
+    villageNeighbors_ = TileBitset(size_);
+    coastalObjectNeighbors_ = TileBitset(size_);
+    if (*stage_ < MapStage::castles) {
+        return;
+    }
+
+    copy_section(file, regionLandmass, regionLandmass_);
+    if (ssize(regionLandmass_) != numRegions_) {
+        throw_corrupt(filename, "wrong number of landmasses");
+    }
+    copy_section(file, castles, castles_);
+    check_indexes(castles_, size_, filename, "castles");
+    for (auto i : castles_) {
+        castleRegions_.push_back(tileRegions_[i]);
+    }
+    copy_section(file, regionCastleDistance, regionCastleDistance_);
+    check_castle_distances(regionCastleDistance_, numRegions_, filename);
+    tileOccupied_ = read_bits(file, tileOccupied, size_, filename);
+    tileWalkable_ = read_bits(file, tileWalkable, size_, filename);
+
+    auto landmasses = read_pairs(file, coastLandmasses, filename);
+    auto terrain = file.section<uint32_t>(coastTerrain);
+    auto offsets = file.section<int>(coastTileOffsets);
+    auto tiles = file.section<int>(coastTiles);
+    if (terrain.size() != landmasses.size() || offsets.size() != landmasses.size() + 1) {
+        throw_corrupt(filename, "wrong number of coastlines");
+    }
+    check_offsets(offsets, tiles.size(), filename, "coastline offsets");
+    check_indexes(tiles, size_, filename, "coastline tiles");
+    for (size_t i = 0; i < landmasses.size(); ++i) {
+        auto &coast = coastlines_.emplace_back(landmasses[i]);
+        for (auto t : Terrain()) {
+            if (terrain[i] & (1u << static_cast<int>(t))) {
+                coast.terrain.set(t);
+            }
+        }
+        coast.tiles.assign(begin(tiles) + offsets[i], begin(tiles) + offsets[i + 1]);
+    }
+}
+
+const std::vector<PhaseStats> & RandomMap::getProfile() const
+{
+    return profile_.phases();
+}
+
+unsigned int RandomMap::seed() const
+{
+    return seed_;
 }
 
 int RandomMap::size() const
@@ -274,7 +733,7 @@ Terrain RandomMap::getTerrain(const Hex &hex) const
 bool RandomMap::getObstacle(int index) const
 {
     assert(!offGrid(index));
-    return tileObstacles_[index] > 0;
+    return tileObstacles_[index];
 }
 
 bool RandomMap::getObstacle(const Hex &hex) const
@@ -288,7 +747,7 @@ bool RandomMap::getWalkable(int index) const
     if (offGrid(index)) {
         return false;
     }
-    return tileWalkable_[index] > 0;
+    return tileWalkable_[index];
 }
 
 bool RandomMap::getWalkable(const Hex &hex) const
@@ -301,7 +760,7 @@ bool RandomMap::getOccupied(int index) const
     if (offGrid(index)) {
         return false;
     }
-    return tileOccupied_[index] > 0;
+    return tileOccupied_[index];
 }
 
 bool RandomMap::getOccupied(const Hex &hex) const
@@ -320,6 +779,112 @@ int RandomMap::tileRegionCastleDistance(int index) const
     return regionCastleDistance_[getRegion(index)];
 }
 
+std::vector<int> RandomMap::tileDistanceField(std::span<const int> srcTiles) const
+{
+    std::vector<int> dist(size_, -1);
+    std::vector<int> bfsQ;
+    bfsQ.reserve(size_);
+    for (int tile : srcTiles) {
+        assert(!offGrid(tile));
+        if (dist[tile] < 0) {
+            dist[tile] = 0;
+            bfsQ.push_back(tile);
+        }
+    }
+
+    // Every tile is pushed at most once, so the queue never wraps around.
+    for (int head = 0; head < ssize(bfsQ); ++head) {
+        const int tile = bfsQ[head];
+        for (int nbr : getTileNeighbors(tile)) {
+            if (dist[nbr] < 0) {
+                dist[nbr] = dist[tile] + 1;
+                bfsQ.push_back(nbr);
+            }
+        }
+    }
+
+    return dist;
+}
+
+std::vector<int> RandomMap::regionDistanceField(std::span<const int> srcRegions) const
+{
+    std::vector<int> dist(numRegions_, -1);
+    std::vector<int> bfsQ;
+    bfsQ.reserve(numRegions_);
+    for (int region : srcRegions) {
+        assert(region >= 0 && region < numRegions_);
+        if (dist[region] < 0) {
+            dist[region] = 0;
+            bfsQ.push_back(region);
+        }
+    }
+
+    for (int head = 0; head < ssize(bfsQ); ++head) {
+        const int region = bfsQ[head];
+        for (int nbr : regionNeighbors_.find(region)) {
+            if (dist[nbr] < 0) {
+                dist[nbr] = dist[region] + 1;
+                bfsQ.push_back(nbr);
+            }
+        }
+    }
+
+    return dist;
+}
+
+std::vector<int> RandomMap::walkingDistanceField(std::span<const int> srcTiles) const
+{
+    std::vector<int> dist(size_, -1);
+    std::vector<int> bfsQ;
+    bfsQ.reserve(size_);
+    for (int tile : srcTiles) {
+        assert(!offGrid(tile));
+        if (dist[tile] < 0) {
+            dist[tile] = 0;
+            bfsQ.push_back(tile);
+        }
+    }
+
+    for (int head = 0; head < ssize(bfsQ); ++head) {
+        const int tile = bfsQ[head];
+        for (int nbr : getTileNeighbors(tile)) {
+            if (dist[nbr] < 0 &&
+                tileWalkable_[nbr] &&
+                getTerrain(nbr) != Terrain::water)
+            {
+                dist[nbr] = dist[tile] + 1;
+                bfsQ.push_back(nbr);
+            }
+        }
+    }
+
+    return dist;
+}
+
+int RandomMap::tileDistance(ObjectType type, int index)
+{
+    assert(!offGrid(index));
+    auto &field = tileObjectDistance_[type];
+    if (field.empty()) {
+        field = tileDistanceField(getObjectTileList(type));
+    }
+    return field[index];
+}
+
+int RandomMap::regionDistance(ObjectType type, int region)
+{
+    assert(region >= 0 && region < numRegions_);
+    auto &field = regionObjectDistance_[type];
+    if (field.empty()) {
+        std::vector<int> srcRegions;
+        for (int tile : getObjectTileList(type)) {
+            srcRegions.push_back(tileRegions_[tile]);
+        }
+        field = regionDistanceField(srcRegions);
+    }
+    return field[region];
+}
+
 FlatMultimap<std::string, int>::ValueRange RandomMap::getObjectTiles(ObjectType type)
 {
     return objectTiles_.find(str_from_ObjectType(type));
@@ -330,17 +895,18 @@ const ObjectManager & RandomMap::getObjectConfig() const
     return *objectMgr_;
 }
 
-FlatMultimap<int, int>::ValueRange RandomMap::getTileRegionNeighbors(int index)
+FlatMultimap<int, int>::ValueRange RandomMap::getTileRegionNeighbors(int index) const
 {
     return tileRegionNeighbors_.find(index);
 }
 
-FlatMultimap<int, int>::ValueRange RandomMap::getTileNeighbors(int index)
+TileNeighbors RandomMap::getTileNeighbors(int index) const
 {
-    return tileNeighbors_.find(index);
+    assert(!offGrid(index));
+    return {index, width_};
 }
 
-FlatMultimap<int, int>::ValueRange RandomMap::getRegionNeighbors(int region)
+FlatMultimap<int, int>::ValueRange RandomMap::getRegionNeighbors(int region) const
 {
     return regionNeighbors_.find(region);
 }
@@ -376,7 +942,7 @@ bool RandomMap::offGrid(const Hex &hex) const
 void RandomMap::generateRegions()
 {
     // Start with a set of random hexes.  Don't worry if there are duplicates.
-    numRegions_ = size_ / REGION_SIZE;
+    numRegions_ = size_ / regionSize;
     std::vector<Hex> centers(numRegions_);
     std::ranges::generate(centers, RandomHex(width_));
      
@@ -397,11 +963,10 @@ void RandomMap::generateRegions()
 void RandomMap::buildNeighborGraphs()
 {
     // Estimate how many nodes we'll need.
-    tileNeighbors_.reserve(size_ * 6);
     regionNeighbors_.reserve(size_);
 
-    // Save every tile and region neighbor, don't worry about duplicates (the
-    // multimap will take care of them).
+    // Save every region neighbor, don't worry about duplicates (the multimap
+    // will take care of them).
     for (int i = 0; i < size_; ++i) {
         for (auto dir : HexDir()) {
             const int nbrTile = intFromHex(hexFromInt(i).getNeighbor(dir));
@@ -409,7 +974,6 @@ void RandomMap::buildNeighborGraphs()
             if (offGrid(nbrTile)) {
                 continue;
             }
-            tileNeighbors_.insert(i, nbrTile);
 
             const int region = tileRegions_[i];
             const int nbrRegion = tileRegions_[nbrTile];
@@ -424,8 +988,8 @@ void RandomMap::buildNeighborGraphs()
     }
 
     // Won't be inserting any new elements after this.
-    tileNeighbors_.shrink_to_fit();
     regionNeighbors_.shrink_to_fit();
+    regionNeighbors_.freeze();
 
     // Multiple steps depend on this list, ensure we're not processing it in tile
     // index order every time.
@@ -435,6 +999,7 @@ void RandomMap::buildNeighborGraphs()
         tileRegionNeighbors_.insert(tile, tileRegions_[nbr]);
     }
     tileRegionNeighbors_.shrink_to_fit();
+    tileRegionNeighbors_.freeze();
 }
 
 void RandomMap::assignTerrain()
@@ -452,7 +1017,7 @@ void RandomMap::assignTerrain()
         if (altitude[i] == 0) {
             regionTerrain_[i] = lowAlt[dist3.get()];
         }
-        else if (altitude[i] == MAX_ALTITUDE) {
+        else if (altitude[i] == maxAltitude) {
             regionTerrain_[i] = highAlt[dist2.get()];
         }
         else {
@@ -463,26 +1028,19 @@ void RandomMap::assignTerrain()
 
 void RandomMap::assignObstacles()
 {
-    Noise noise;
+    Noise noise(RandomRange::split_seed(seed_, 0));
 
     // Assign each tile a random noise value.
-    std::vector<double> values;
-    values.reserve(size_);
-    for (int y = 0; y < width_; ++y) {
-        for (int x = 0; x < width_; ++x) {
-            values.push_back(noise.get(x, y));
-        }
-    }
+    auto values = noise.getAll(width_, numThreads_);
 
     // Any value above the threshold gets an obstacle.
-    for (int i = 0; i < size_; ++i) {
-        if (values[i] > OBSTACLE_LEVEL &&
-            !tileOccupied_[i] &&
-            !coastalObjectNeighbors_[i])
-        {
+    auto open = tileOccupied_ | coastalObjectNeighbors_;
+    open.flip();
+    open.forEachSet([this, &values] (int i) {
+        if (values[i] > obstacleLevel) {
             setObstacle(i);
         }
-    }
+    });
 
     avoidIsolatedRegions();
     avoidIsolatedTiles();
@@ -490,30 +1048,55 @@ void RandomMap::assignObstacles()
 
 void RandomMap::assignRegions(const std::vector<Hex> &centers)
 {
-    for (int i = 0; i < size_; ++i) {
-        tileRegions_[i] = hexClosestIdx(hexFromInt(i), centers);
-    }
+    tileRegions_ = hexClosestIdxGrid(width_, centers, numThreads_);
 }
 
 void RandomMap::mapRegionsToTiles()
 {
-    regionTiles_.reserve(size_);
+    // Counting sort by region.  Tiles within each region stay in index order,
+    // the same order the multimap would sort them into.
+    std::vector<int> regionStart(numRegions_ + 1, 0);
+    for (int r : tileRegions_) {
+        ++regionStart[r + 1];
+    }
+    std::partial_sum(begin(regionStart), end(regionStart), begin(regionStart));
+
+    std::vector<FlatMultimap<int, int>::KeyValue> sorted(size_);
     for (int i = 0; i < size_; ++i) {
-        regionTiles_.insert(tileRegions_[i], i);
+        const int r = tileRegions_[i];
+        sorted[regionStart[r]++] = {r, i};
     }
+    regionTiles_.assignSorted(sorted);
+    regionTiles_.freeze();
 }
 
 std::vector<Hex> RandomMap::voronoi()
 {
     std::vector<Hex> centers(numRegions_);
 
-    // Count all the hexes assigned to each region, sum their coordinates.
-    std::vector<Hex> hexSums(numRegions_, {0, 0});
-    std::vector<int> hexCount(numRegions_, 0);
-    for (int i = 0; i < size_; ++i) {
-        auto reg = tileRegions_[i];
-        hexSums[reg] += hexFromInt(i);
-        ++hexCount[reg];
+    // Count all the hexes assigned to each region, sum their coordinates.  Each
+    // thread keeps its own totals for a block of tiles, then we add them up.
+    std::vector<std::vector<Hex>> partialSums(numThreads_,
+                                              std::vector<Hex>(numRegions_, {0, 0}));
+    std::vector<std::vector<int>> partialCounts(numThreads_,
+                                                std::vector<int>(numRegions_, 0));
+    parallel_blocks(size_, numThreads_, [&] (int first, int last, int block) {
+        auto &hexSums = partialSums[block];
+        auto &hexCount = partialCounts[block];
+        for (int i = first; i < last; ++i) {
+            auto reg = tileRegions_[i];
+            hexSums[reg] += hexFromInt(i);
+            ++hexCount[reg];
+        }
+    });
+
+    auto &hexSums = partialSums[0];
+    auto &hexCount = partialCounts[0];
+    for (int t = 1; t < numThreads_; ++t) {
+        for (int r = 0; r < numRegions_; ++r) {
+            hexSums[r] += partialSums[t][r];
+            hexCount[r] += partialCounts[t][r];
+        }
     }
 
     // Find the average hex for each region.
@@ -551,7 +1134,7 @@ std::vector<int> RandomMap::randomAltitudes()
             }
 
             const auto newAlt = altitude[curRegion] + step.get();
-            altitude[nbrRegion] = std::clamp(newAlt, 0, MAX_ALTITUDE);
+            altitude[nbrRegion] = std::clamp(newAlt, 0, maxAltitude);
             regionStack.push_back(nbrRegion);
         }
     }
@@ -564,9 +1147,9 @@ std::vector<int> RandomMap::randomAltitudes()
 void RandomMap::setObstacle(int index)
 {
     assert(!offGrid(index) && !tileOccupied_[index]);
-    tileObstacles_[index] = 1;
-    tileOccupied_[index] = 1;
-    tileWalkable_[index] = 0;
+    tileObstacles_.set(index);
+    tileOccupied_.set(index);
+    tileWalkable_.reset(index);
 }
 
 void RandomMap::clearObstacle(int index)
@@ -576,9 +1159,9 @@ void RandomMap::clearObstacle(int index)
         return;
     }
 
-    tileObstacles_[index] = 0;
-    tileOccupied_[index] = 0;
-    tileWalkable_[index] = 1;
+    tileObstacles_.reset(index);
+    tileOccupied_.reset(index);
+    tileWalkable_.set(index);
 }
 
 void RandomMap::avoidIsolatedRegions()
@@ -602,7 +1185,7 @@ void RandomMap::avoidIsolatedRegions()
         // If obstacles on both sides, clear them. Also clear this side only if
         // the neighbor tile is walkable.
         else if (tileObstacles_[tile] &&
-                 (tileObstacles_[nbr] >= 0 || tileWalkable_[nbr]))
+                 (tileObstacles_[nbr] || tileWalkable_[nbr]))
         {
             clearObstacle(tile);
             clearObstacle(nbr);
@@ -614,100 +1197,101 @@ void RandomMap::avoidIsolatedRegions()
 
 void RandomMap::avoidIsolatedTiles()
 {
-    std::vector<signed char> tileVisited(size_, 0);
-    std::vector<signed char> regionVisited(numRegions_, 0);
+    // Group the walkable tiles of each region into connected pockets.
+    DisjointSets pockets(size_);
+    auto joinNeighbors = [this, &pockets] (int tile) {
+        for (int nbr : getTileNeighbors(tile)) {
+            if (tileWalkable_[nbr] && tileRegions_[nbr] == tileRegions_[tile]) {
+                pockets.join(tile, nbr);
+            }
+        }
+    };
+    tileWalkable_.forEachSet(joinNeighbors);
 
-    for (int i = 0; i < size_; ++i) {
-        if (!tileWalkable_[i]) {
-            continue;
+    // Each tile is in exactly one region, so these never need to be reset.
+    std::vector<int> cost(size_, -1);
+    std::vector<int> cameFrom(size_, invalidIndex);
+    std::deque<int> bfsQ;
+    std::vector<int> isolated;
+
+    for (int r = 0; r < numRegions_; ++r) {
+        // The largest pocket is the one everything else has to reach.
+        int mainRoot = invalidIndex;
+        for (int tile : regionTiles_.find(r)) {
+            if (!tileWalkable_[tile]) {
+                continue;
+            }
+            const int root = pockets.find(tile);
+            if (mainRoot == invalidIndex ||
+                pockets.setSize(root) > pockets.setSize(mainRoot))
+            {
+                mainRoot = root;
+            }
         }
 
-        const int reg = tileRegions_[i];
-        if (!regionVisited[reg]) {
-            exploreWalkableTiles(i, tileVisited);
-            regionVisited[reg] = 1;
+        isolated.clear();
+        for (int tile : regionTiles_.find(r)) {
+            if (tileWalkable_[tile]) {
+                if (pockets.find(tile) == mainRoot) {
+                    cost[tile] = 0;
+                    bfsQ.push_back(tile);
+                }
+                else {
+                    isolated.push_back(tile);
+                }
+            }
         }
-        else if (!tileVisited[i]) {
-            // We've found an unreachable tile within a region that was already
-            // visited.
-            connectIsolatedTiles(i, tileVisited);
-            exploreWalkableTiles(i, tileVisited);
+        if (isolated.empty()) {
+            bfsQ.clear();
+            continue;
         }
-    }
-}
 
-void RandomMap::exploreWalkableTiles(int startTile, std::vector<signed char> &visited)
-{
-    const int region = tileRegions_[startTile];
-    std::queue<int> bfsQ;
+        // 0-1 breadth-first search outward from the main pocket.  Stepping onto
+        // an obstacle costs 1, so each tile ends up with the fewest obstacles
+        // that have to be cleared to reach it.  Castles and other objects are
+        // in the way.
+        while (!bfsQ.empty()) {
+            const int tile = bfsQ.front();
+            bfsQ.pop_front();
 
-    // Breadth-first-search from starting tile to try to find every walkable tile
-    // in same region.
-    bfsQ.push(startTile);
-    while (!bfsQ.empty()) {
-        const int tile = bfsQ.front();
-        visited[tile] = 1;
-        bfsQ.pop();
+            for (int nbr : getTileNeighbors(tile)) {
+                if (tileRegions_[nbr] != r ||
+                    (!tileWalkable_[nbr] && !tileObstacles_[nbr]))
+                {
+                    continue;
+                }
 
-        for (const auto &nbr : tileNeighbors_.find(tile)) {
-            if (tileRegions_[nbr] == region &&
-                !visited[nbr] &&
-                tileWalkable_[nbr])
-            {
-                bfsQ.push(nbr);
+                const int nbrCost = cost[tile] + (tileObstacles_[nbr] ? 1 : 0);
+                if (cost[nbr] < 0 || nbrCost < cost[nbr]) {
+                    cost[nbr] = nbrCost;
+                    cameFrom[nbr] = tile;
+                    if (tileObstacles_[nbr]) {
+                        bfsQ.push_back(nbr);
+                    }
+                    else {
+                        bfsQ.push_front(nbr);
+                    }
+                }
             }
         }
-    }
-}
-
-void RandomMap::connectIsolatedTiles(int startTile,
-                                     const std::vector<signed char> &visited)
-{
-    const int region = tileRegions_[startTile];
-    std::queue<int> bfsQ;
-    boost::container::flat_map<int, int> cameFrom;
-    int pathStart = invalidIndex;
-
-    // Search for the nearest visited walkable tile in the same region.  Clear a
-    // path of obstacles to get there.
-    bfsQ.push(startTile);
-    cameFrom.emplace(startTile, invalidIndex);
-    while (pathStart == invalidIndex && !bfsQ.empty()) {
-        const int tile = bfsQ.front();
-        bfsQ.pop();
 
-        for (const auto &nbr : tileNeighbors_.find(tile)) {
-            if (tileRegions_[nbr] != region) {
+        // Clear the obstacles between each pocket and the main one.  A path
+        // might run through other pockets, so skip any that are already
+        // connected.
+        for (int tile : isolated) {
+            // Walled in by objects.  Can't happen unless object placement went
+            // wrong.
+            assert(cost[tile] >= 0);
+            if (cost[tile] < 0 || pockets.same(tile, mainRoot)) {
                 continue;
             }
-            else if (visited[nbr] && tileWalkable_[nbr]) {
-                // Goal node, stop.
-                cameFrom.emplace(nbr, tile);
-                pathStart = nbr;
-                break;
-            }
-            else if (cameFrom.find(nbr) == std::cend(cameFrom)) {
-                // Haven't visited this tile yet. Make sure the path doesn't
-                // include a castle tile or other object.
-                if (tileWalkable_[nbr] || tileObstacles_[nbr]) {
-                    bfsQ.push(nbr);
-                    cameFrom.emplace(nbr, tile);
-                }
+
+            for (int t = tile; t != invalidIndex; t = cameFrom[t]) {
+                clearObstacle(t);
+                joinNeighbors(t);
             }
         }
     }
-
-    // We should always find a valid path to a previously visited walkable tile.
-    // Otherwise, why did we get in here?
-    assert(!offGrid(pathStart));
-
-    // Clear obstacles along the path.
-    int t = pathStart;
-    while (!offGrid(t)) {
-        clearObstacle(t);
-        assert(cameFrom.find(t) != std::cend(cameFrom));
-        t = cameFrom[t];
-    }
 }
 
 void RandomMap::placeCastles()
@@ -727,10 +1311,10 @@ void RandomMap::placeCastles()
         // Mark all the castle tiles occupied so other objects don't overlap them.
         // Also set the castle interior as unwalkable.
         for (const auto &hex : getCastleHexes(centerHex)) {
-            tileOccupied_[intFromHex(hex)] = 1;
+            tileOccupied_.set(intFromHex(hex));
         }
         for (const auto &hex : getUnwalkableCastleHexes(centerHex)) {
-            tileWalkable_[intFromHex(hex)] = 0;
+            tileWalkable_.reset(intFromHex(hex));
         }
 
         const auto centerTile = intFromHex(centerHex);
@@ -738,6 +1322,7 @@ void RandomMap::placeCastles()
         castleRegions_.push_back(tileRegions_[centerTile]);
     }
 
+    clearDistanceFields(ObjectType::castle);
     computeCastleDistance();
 }
 
@@ -750,10 +1335,13 @@ Hex RandomMap::findCastleSpot(int startTile)
     std::vector<signed char> regionRuledOut(numRegions_, 0);
 
     // Breadth-first search to find a suitable location for each castle.
+    // Mark tiles visited as they're queued.  Otherwise a tile can be queued
+    // once per neighbor, and the queue blows up when there's no valid spot
+    // nearby.
     bfsQ.push(startTile);
+    visited[startTile] = 1;
     while (!bfsQ.empty()) {
         const auto tile = bfsQ.front();
-        visited[tile] = 1;
         bfsQ.pop();
 
         // all tiles must be in the same region
@@ -782,8 +1370,9 @@ Hex RandomMap::findCastleSpot(int startTile)
             regionRuledOut[curRegion] = 1;
         }
 
-        for (const auto &nbr : tileNeighbors_.find(tile)) {
+        for (const auto &nbr : getTileNeighbors(tile)) {
             if (!visited[nbr]) {
+                visited[nbr] = 1;
                 bfsQ.push(nbr);
             }
         }
@@ -809,53 +1398,13 @@ bool RandomMap::isCastleRegionValid(int region)
 
 void RandomMap::computeCastleDistance()
 {
-    regionCastleDistance_.resize(numRegions_);
-    for (int r = 0; r < numRegions_; ++r) {
-        int distance = 0;
-        if (!contains(castleRegions_, r)) {
-            distance = computeCastleDistance(r);
-        }
+    regionCastleDistance_ = regionDistanceField(castleRegions_);
 
-        regionCastleDistance_[r] = distance;
-    }
-}
-
-int RandomMap::computeCastleDistance(int region)
-{
-    boost::container::flat_map<int, int> cameFrom;
-    std::queue<int> bfsQ;
-
-    // Breadth-first search for the nearest castle region.
-    bfsQ.push(region);
-    while (!bfsQ.empty()) {
-        int r = bfsQ.front();
-        bfsQ.pop();
-
-        for (auto nbr : regionNeighbors_.find(r)) {
-            if (nbr == region || cameFrom.find(nbr) != std::cend(cameFrom)) {
-                continue;
-            }
-            else if (!contains(castleRegions_, nbr)) {
-                bfsQ.push(nbr);
-                cameFrom.emplace(nbr, r);
-            }
-            else {
-                // Castle found in neighboring region, count back to starting
-                // region.
-                int distance = 1;
-                auto iter = cameFrom.find(r);
-                while (iter != std::cend(cameFrom)) {
-                    ++distance;
-                    iter = cameFrom.find(iter->second);
-                }
-                return distance;
-            }
-        }
-    }
-
-    // Can't get here unless we messed up region neighbors or don't have any
+    // Can't happen unless we messed up region neighbors or don't have any
     // castles.
-    throw std::runtime_error("Couldn't find nearest castle from region");
+    if (std::ranges::find(regionCastleDistance_, -1) != regionCastleDistance_.end()) {
+        throw std::runtime_error("Couldn't find nearest castle from region");
+    }
 }
 
 void RandomMap::computeLandmasses()
@@ -870,19 +1419,21 @@ void RandomMap::computeLandmasses()
 
         // Breadth-first search for all contiguous regions that are similar
         // (either land or water) to this one.
+        // Mark each region as it's pushed so it can't be queued more than once.
         bool isWater = (regionTerrain_[r] == Terrain::water);
         std::queue<int> bfsQ;
         bfsQ.push(r);
+        regionLandmass_[r] = curLandmass;
         while (!bfsQ.empty()) {
             int region = bfsQ.front();
             bfsQ.pop();
-            regionLandmass_[region] = curLandmass;
 
             for (int nbr : regionNeighbors_.find(region)) {
                 if (regionLandmass_[nbr] >= 0) {
                     continue;
                 }
                 if (isWater == (regionTerrain_[nbr] == Terrain::water)) {
+                    regionLandmass_[nbr] = curLandmass;
                     bfsQ.push(nbr);
                 }
             }
@@ -929,47 +1480,84 @@ void RandomMap::computeCoastlines()
     }
 }
 
-int RandomMap::getRandomTile(int region)
+void RandomMap::initTilePool()
 {
-    const auto regTiles = regionTiles_.find(region);
-    RandomRange dist(0, regTiles.size() - 1);
-    return *std::next(regTiles.begin(), dist.get());
+    tilePool_.clear();
+    tilePool_.reserve(size_);
+    tilePoolPos_.assign(size_, -1);
+    regionPoolStart_.assign(numRegions_, 0);
+
+    auto freeTiles = getFreeTiles();
+    regionPoolSize_ = countByRegion(freeTiles);
+    for (int r = 1; r < numRegions_; ++r) {
+        regionPoolStart_[r] = regionPoolStart_[r - 1] + regionPoolSize_[r - 1];
+    }
+
+    // Tiles within each region go in increasing index order.
+    tilePool_.resize(freeTiles.count());
+    std::vector<int> regionFill = regionPoolStart_;
+    freeTiles.forEachSet([this, &regionFill] (int tile) {
+        const int pos = regionFill[tileRegions_[tile]]++;
+        tilePoolPos_[tile] = pos;
+        tilePool_[pos] = tile;
+    });
 }
 
-int RandomMap::findObjectSpot(int startTile, int region)
+TileBitset RandomMap::getFreeTiles() const
 {
-    assert(!offGrid(startTile));
+    auto freeTiles = tileOccupied_ | villageNeighbors_;
+    freeTiles |= coastalObjectNeighbors_;
+    return freeTiles.flip();
+}
 
-    std::queue<int> bfsQ;
-    boost::container::flat_set<int> visited;
+std::vector<int> RandomMap::countByRegion(const TileBitset &tiles) const
+{
+    std::vector<int> counts(numRegions_, 0);
+    tiles.forEachSet([this, &counts] (int tile) { ++counts[tileRegions_[tile]]; });
+    return counts;
+}
 
-    // Breadth-first search to find a suitable location.
-    bfsQ.push(startTile);
-    while (!bfsQ.empty()) {
-        const auto tile = bfsQ.front();
-        visited.insert(tile);
-        bfsQ.pop();
+bool RandomMap::isTileFree(int index) const
+{
+    return !tileOccupied_[index] &&
+        !villageNeighbors_[index] &&
+        !coastalObjectNeighbors_[index];
+}
 
-        if (offGrid(tile) || tileRegions_[tile] != region) {
-            continue;
-        }
+void RandomMap::removeFromPool(int index)
+{
+    if (tilePoolPos_.empty() || tilePoolPos_[index] < 0) {
+        return;
+    }
 
-        if (!tileOccupied_[tile] &&
-            !villageNeighbors_[tile] &&
-            !coastalObjectNeighbors_[tile])
-        {
-            return tile;
-        }
+    // Swap with the last free tile in the same region.
+    const int region = tileRegions_[index];
+    const int pos = tilePoolPos_[index];
+    const int lastPos = regionPoolStart_[region] + --regionPoolSize_[region];
+    const int lastTile = tilePool_[lastPos];
+    tilePool_[pos] = lastTile;
+    tilePoolPos_[lastTile] = pos;
+    tilePool_[lastPos] = index;
+    tilePoolPos_[index] = -1;
+}
 
-        for (const auto &nbr : tileNeighbors_.find(tile)) {
-            if (visited.find(nbr) == std::cend(visited)) {
-                bfsQ.push(nbr);
+bool RandomMap::isTilePoolValid() const
+{
+    // Same number of tiles, and each one is free and in the right place.
+    const auto freeTiles = getFreeTiles();
+    if (countByRegion(freeTiles) != regionPoolSize_) {
+        return false;
+    }
+    for (int r = 0; r < numRegions_; ++r) {
+        const int first = regionPoolStart_[r];
+        for (int pos = first; pos < first + regionPoolSize_[r]; ++pos) {
+            const int tile = tilePool_[pos];
+            if (!freeTiles[tile] || tileRegions_[tile] != r || tilePoolPos_[tile] != pos) {
+                return false;
             }
         }
     }
-
-    // No walkable tiles remaining in this region.
-    return invalidIndex;
+    return true;
 }
 
 int RandomMap::numObjectsAllowed(const MapObject &obj, int region) const
@@ -989,6 +1577,8 @@ int RandomMap::numObjectsAllowed(const MapObject &obj, int region) const
 
 void RandomMap::placeVillages()
 {
+    initTilePool();
+
     for (int r = 0; r < numRegions_; ++r) {
         auto &village = objectMgr_->find(ObjectType::village);
         assert(village.type == ObjectType::village);
@@ -1002,12 +1592,15 @@ void RandomMap::placeVillages()
 
             // Block off a one-hex radius around villages to prevent two from
             // being placed next to each other.
-            villageNeighbors_[tile] = 1;
-            for (int nbr : tileNeighbors_.find(tile)) {
-                villageNeighbors_[nbr] = 1;
+            villageNeighbors_.set(tile);
+            for (int nbr : getTileNeighbors(tile)) {
+                villageNeighbors_.set(nbr);
+                removeFromPool(nbr);
             }
         }
     }
+
+    assert(isTilePoolValid());
 }
 
 void RandomMap::placeObjects()
@@ -1031,6 +1624,8 @@ void RandomMap::placeObjects()
             placeCoastalObject(obj);
         }
     }
+
+    assert(isTilePoolValid());
 }
 
 void RandomMap::placeCoastalObject(const MapObject &obj)
@@ -1075,9 +1670,10 @@ void RandomMap::placeCoastalObject(const MapObject &obj)
 
                 // Like with villages, block off a 1-hex radius to keep adjacent
                 // land and water tiles open.
-                coastalObjectNeighbors_[bestTile] = 1;
+                coastalObjectNeighbors_.set(bestTile);
                 for (int iNbr : getTileNeighbors(bestTile)) {
-                    coastalObjectNeighbors_[iNbr] = 1;
+                    coastalObjectNeighbors_.set(iNbr);
+                    removeFromPool(iNbr);
                 }
             }
         }
@@ -1086,12 +1682,17 @@ void RandomMap::placeCoastalObject(const MapObject &obj)
 
 int RandomMap::placeObjectInRegion(ObjectType type, int region)
 {
-    int startTile = getRandomTile(region);
-    int tile = findObjectSpot(startTile, region);
-    if (!offGrid(tile)) {
-        placeObject(type, tile);
+    // No open tiles remaining in this region.
+    const int poolSize = regionPoolSize_[region];
+    if (poolSize == 0) {
+        return invalidIndex;
     }
 
+    RandomRange dist(0, poolSize - 1);
+    const int tile = tilePool_[regionPoolStart_[region] + dist.get()];
+    assert(isTileFree(tile));
+    placeObject(type, tile);
+
     return tile;
 }
 
@@ -1099,7 +1700,9 @@ void RandomMap::placeObject(ObjectType type, int tile)
 {
     auto name = str_from_ObjectType(type);
     objectTiles_.insert(std::string(name), tile);
-    tileOccupied_[tile] = 1;  // object tiles are walkable
+    tileOccupied_.set(tile);  // object tiles are walkable
+    removeFromPool(tile);
+    clearDistanceFields(type);
 }
 
 void RandomMap::placeArmies()
@@ -1108,13 +1711,13 @@ void RandomMap::placeArmies()
     boost::container::flat_set<std::pair<int, int>> placed;
 
     // Avoid placing an army such that zones of control overlap.
-    boost::container::flat_set<int> controlled;
+    TileBitset controlled(size_);
 
     for (auto [tile, nbr] : borderTiles_) {
         if (tileOccupied_[tile] || !tileWalkable_[tile] || !tileWalkable_[nbr]) {
             continue;
         }
-        if (controlled.contains(tile) || villageNeighbors_[tile]) {
+        if (controlled[tile] || villageNeighbors_[tile]) {
             continue;
         }
 
@@ -1137,10 +1740,27 @@ void RandomMap::placeArmies()
         placed.insert({region, nbrRegion});
         placed.insert({nbrRegion, region});
 
-        for (int zoc : tileNeighbors_.find(tile)) {
-            for (int zoc2 : tileNeighbors_.find(zoc)) {
-                controlled.insert(zoc2);
+        for (int zoc : getTileNeighbors(tile)) {
+            for (int zoc2 : getTileNeighbors(zoc)) {
+                controlled.set(zoc2);
             }
         }
     }
 }
+
+std::vector<int> RandomMap::getObjectTileList(ObjectType type)
+{
+    // Castles are stored separately from the other objects.
+    if (type == ObjectType::castle) {
+        return castles_;
+    }
+
+    auto tiles = getObjectTiles(type);
+    return {tiles.begin(), tiles.end()};
+}
+
+void RandomMap::clearDistanceFields(ObjectType type)
+{
+    tileObjectDistance_[type].clear();
+    regionObjectDistance_[type].clear();
+}
@@ -1,5 +1,5 @@
 /*
-    Copyright (C) 2016-2024 by Michael Kristofik <kristo605@gmail.com>
+    Copyright (C) 2016-2025 by Michael Kristofik <kristo605@gmail.com>
     Part of the Champions of Anduran project.
  
     This program is free software; you can redistribute it and/or modify
@@ -15,8 +15,15 @@
 
 #include "FlatMultimap.h"
 #include "ObjectManager.h"
+#include "TileBitset.h"
 #include "hex_utils.h"
+#include "iterable_enum_class.h"
+#include "profile_utils.h"
 #include "terrain.h"
+#include <functional>
+#include <optional>
+#include <random>
+#include <span>
 #include <string>
 #include <vector>
 
@@ -34,14 +41,55 @@ struct Coastline
 };
 
 
+// Generating a map happens in these stages, in order:
+// - regions: divide the map into regions and assign each one a terrain type
+// - castles: group regions into landmasses, find coastlines, place castles
+// - objects: villages, other objects, obstacles, and wandering armies
+ITERABLE_ENUM_CLASS(MapStage, regions, castles, objects);
+
+
 class RandomMap
 {
 public:
-    RandomMap(int width, const ObjectManager &objMgr);
+    // Called after each generation stage finishes, e.g. to save a checkpoint.
+    using StageCallback = std::function<void(RandomMap &, MapStage)>;
+
+    // The same seed and width always generate the same map.  Generating a new
+    // map can optionally split the work across threads.  The result doesn't
+    // depend on the number of threads used.
+    RandomMap(int width,
+              unsigned int seed,
+              const ObjectManager &objMgr,
+              int numThreads = 1,
+              const StageCallback &onStageDone = {});
+    // Load a map saved in either format below.
     RandomMap(const char *filename, const ObjectManager &objMgr);
 
+    // Finish generating a map from a checkpoint, running only the stages after
+    // the one it was saved at.  Without a reroll seed, the result is the same
+    // as generating the whole map at once.  With one, the later stages make
+    // different random choices (e.g., new objects on the same terrain).
+    static RandomMap resume(const char *checkpoint,
+                            const ObjectManager &objMgr,
+                            std::optional<unsigned int> rerollSeed = {},
+                            int numThreads = 1,
+                            const StageCallback &onStageDone = {});
+
+    // Save everything the remaining stages need, as of the last stage that
+    // finished.
+    void writeCheckpoint(const char *filename) const;
+
     void writeFile(const char *filename);
 
+    // Compact binary format.  Includes the neighbor graphs so loading doesn't
+    // have to rebuild them.
+    void writeBinaryFile(const char *filename);
+
+    // Time and memory spent on each step of generating the map.  Empty if the
+    // map was loaded from a file.
+    const std::vector<PhaseStats> & getProfile() const;
+
+    unsigned int seed() const;
     int size() const;
     int width() const;
     int numRegions() const;
@@ -64,6 +112,23 @@ public:
     std::vector<Hex> getCastleTiles() const;
     int tileRegionCastleDistance(int index) const;
 
+    // Distance from every tile to the nearest source tile, in tiles, or from
+    // every region to the nearest source region, in regions.  Obstacles don't
+    // matter.  Each one is a single breadth-first search from all the sources
+    // at once.  Tiles or regions that can't be reached get -1.
+    std::vector<int> tileDistanceField(std::span<const int> srcTiles) const;
+    std::vector<int> regionDistanceField(std::span<const int> srcRegions) const;
+
+    // Same as tileDistanceField(), but on foot: only through walkable land
+    // tiles.
+    std::vector<int> walkingDistanceField(std::span<const int> srcTiles) const;
+
+    // Distance to the nearest object of the given type (or the region
+    // containing one), using the fields above.  Each object type's fields are
+    // computed the first time they're needed.
+    int tileDistance(ObjectType type, int index);
+    int regionDistance(ObjectType type, int region);
+
     // Return a list of tiles containing a given object type.
     FlatMultimap<std::string, int>::ValueRange getObjectTiles(ObjectType type);
     auto getObjectHexes(ObjectType type);
@@ -71,11 +136,11 @@ public:
 
     // Return the region(s) adjacent to the given border tile, or an empty range
     // if tile is not on a border with another region.
-    FlatMultimap<int, int>::ValueRange getTileRegionNeighbors(int index);
+    FlatMultimap<int, int>::ValueRange getTileRegionNeighbors(int index) const;
 
     // Return all adjacent tiles or regions that aren't outside the map grid.
-    FlatMultimap<int, int>::ValueRange getTileNeighbors(int index);
-    FlatMultimap<int, int>::ValueRange getRegionNeighbors(int region);
+    TileNeighbors getTileNeighbors(int index) const;
+    FlatMultimap<int, int>::ValueRange getRegionNeighbors(int region) const;
 
     // Convert between integer and Hex representations of a tile location.
     Hex hexFromInt(int index) const;
@@ -89,7 +154,24 @@ public:
 
     static constexpr int invalidIndex = -1;
 
+    // Generation settings, shared with ChunkedMapGenerator so both make the
+    // same kind of map.  Tiles whose noise value is above the obstacle level get
+    // an obstacle.
+    static constexpr int regionSize = 64;  // average tiles per region
+    static constexpr int maxAltitude = 3;
+    static constexpr double obstacleLevel = 0.2;
+
 private:
+    // Empty map, for the loading functions to fill in.
+    RandomMap(const ObjectManager &objMgr, int numThreads);
+
+    void readJsonFile(const char *filename);
+    void readBinaryFile(const char *filename);
+    void readCheckpoint(const char *filename);
+
+    // Run every generation stage after 'lastDone' (or all of them).
+    void runStages(std::optional<MapStage> lastDone, const StageCallback &onStageDone);
+
     void generateRegions();
     void buildNeighborGraphs();
     void landmass();
@@ -112,11 +194,9 @@ private:
 
     // Clear obstacles so each region can reach at least one other region. Also,
     // ensure that every open tile within each region can reach every other open
-    // tile within that region.
+    // tile within that region, clearing as few obstacles as possible.
     void avoidIsolatedRegions();
     void avoidIsolatedTiles();
-    void exploreWalkableTiles(int startTile, std::vector<signed char> &visited);
-    void connectIsolatedTiles(int startTile, const std::vector<signed char> &visited);
 
     // Randomly place castles on the map, trying to be as far apart as possible.
     // Ensure the castle entrances are walkable.
@@ -127,14 +207,19 @@ private:
     // Compute the distance (in regions) each region is from the nearest castle.
     // We'll use this to place certain objects and generate wandering army sizes.
     void computeCastleDistance();
-    int computeCastleDistance(int region);
 
     void computeLandmasses();
     void computeCoastlines();
 
-    // Randomly place various objects in each region.
-    int getRandomTile(int region);
-    int findObjectSpot(int startTile, int region);
+    // Randomly place various objects in each region.  Each region keeps a pool
+    // of tiles where an object could still go, and tiles leave the pool as
+    // objects are placed on or next to them.
+    void initTilePool();
+    TileBitset getFreeTiles() const;
+    std::vector<int> countByRegion(const TileBitset &tiles) const;  // popcount per region
+    bool isTileFree(int index) const;
+    void removeFromPool(int index);
+    bool isTilePoolValid() const;  // each region's pool holds its free tiles
     int numObjectsAllowed(const MapObject &obj, int region) const;
     void placeVillages();
     void placeObjects();
@@ -143,14 +228,18 @@ private:
     void placeObject(ObjectType type, int tile);
     void placeArmies();
 
+    std::vector<int> getObjectTileList(ObjectType type);
+    void clearDistanceFields(ObjectType type);
+
     int width_;
     int size_;
     int numRegions_;
+    int numThreads_;
+    unsigned int seed_;
     std::vector<int> tileRegions_;  // index of region each tile belongs to
-    FlatMultimap<int, int> tileNeighbors_;
-    std::vector<signed char> tileObstacles_;
-    std::vector<signed char> tileOccupied_;
-    std::vector<signed char> tileWalkable_;
+    TileBitset tileObstacles_;
+    TileBitset tileOccupied_;
+    TileBitset tileWalkable_;
     std::vector<std::pair<int, int>> borderTiles_;  // neighbors in different regions
     FlatMultimap<int, int> tileRegionNeighbors_;  // region(s) tile is adjacent to
     FlatMultimap<int, int> regionNeighbors_;
@@ -161,10 +250,19 @@ private:
     std::vector<int> castles_;  // center tile of each castle
     std::vector<int> castleRegions_;
     std::vector<int> regionCastleDistance_;  // how far from nearest castle?
-    std::vector<signed char> villageNeighbors_;
-    std::vector<signed char> coastalObjectNeighbors_;
+    TileBitset villageNeighbors_;
+    TileBitset coastalObjectNeighbors_;
+    std::vector<int> tilePool_;  // free tiles, grouped by region
+    std::vector<int> tilePoolPos_;  // where each tile is in the pool, or -1
+    std::vector<int> regionPoolStart_;
+    std::vector<int> regionPoolSize_;
     FlatMultimap<std::string, int> objectTiles_;
+    EnumSizedArray<std::vector<int>, ObjectType> tileObjectDistance_;
+    EnumSizedArray<std::vector<int>, ObjectType> regionObjectDistance_;
     const ObjectManager *objectMgr_;
+    PhaseProfiler profile_;
+    std::optional<MapStage> stage_;  // last generation stage finished
+    std::mt19937 stageEngine_;  // random number state at the end of that stage
 };
 
 
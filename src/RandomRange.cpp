@@ -1,5 +1,5 @@
 /*
-    Copyright (C) 2021 by Michael Kristofik <kristo605@gmail.com>
+    Copyright (C) 2021-2025 by Michael Kristofik <kristo605@gmail.com>
     Part of the Champions of Anduran project.
  
     This program is free software; you can redistribute it and/or modify
@@ -11,10 +11,27 @@
     See the COPYING.txt file for more details.
 */
 #include "RandomRange.h"
+
+#include <atomic>
+#include <cstdint>
 #include <ctime>
 
-std::mt19937 RandomRange::engine(static_cast<unsigned int>(std::time(nullptr)));
-RandomRange::DistType RandomRange::dist;
+namespace
+{
+    std::atomic<unsigned int> numThreadsSeeded = 0;
+
+    std::mt19937 make_engine()
+    {
+        // Mix in a per-thread counter so threads started in the same second
+        // don't all get the same sequence.
+        std::seed_seq seq{static_cast<unsigned int>(std::time(nullptr)),
+                          numThreadsSeeded++};
+        return std::mt19937(seq);
+    }
+}
+
+
+thread_local std::mt19937 RandomRange::engine = make_engine();
 
 RandomRange::RandomRange(int minVal, int maxVal)
     : range_(minVal, maxVal)
@@ -33,5 +50,33 @@ int RandomRange::max() const
 
 int RandomRange::get() const
 {
-    return dist(engine, range_);
+    DistType dist(range_);
+    return dist(engine);
+}
+
+void RandomRange::seed(unsigned int s)
+{
+    engine.seed(s);
+}
+
+// source: SplitMix64, http://prng.di.unimi.it/splitmix64.c
+unsigned int RandomRange::split_seed(unsigned int s, unsigned int stream)
+{
+    auto z = (static_cast<uint64_t>(s) << 32 | stream) + 0x9e3779b97f4a7c15ull;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    z = z ^ (z >> 31);
+    return static_cast<unsigned int>(z >> 32);
+}
+
+
+ScopedRandomSeed::ScopedRandomSeed(unsigned int s)
+    : saved_(RandomRange::engine)
+{
+    RandomRange::seed(s);
+}
+
+ScopedRandomSeed::~ScopedRandomSeed()
+{
+    RandomRange::engine = saved_;
 }
@@ -1,5 +1,5 @@
 /*
-    Copyright (C) 2021 by Michael Kristofik <kristo605@gmail.com>
+    Copyright (C) 2021-2025 by Michael Kristofik <kristo605@gmail.com>
     Part of the Champions of Anduran project.
  
     This program is free software; you can redistribute it and/or modify
@@ -27,12 +27,37 @@ public:
     // Generate one random number in the closed range [min(), max()].
     int get() const;
 
-    static std::mt19937 engine;
+    // Every thread has its own engine, so threads never share random number
+    // state.  Each one starts out seeded differently.  Reseed it to make a
+    // thread's sequence of numbers repeatable.
+    static thread_local std::mt19937 engine;
+    static void seed(unsigned int s);
+
+    // Derive an independent seed for a numbered sub-task (one map out of a
+    // batch, one worker thread, etc.) from a parent seed.  The same inputs
+    // always produce the same result.
+    static unsigned int split_seed(unsigned int s, unsigned int stream);
 
 private:
     using DistType = std::uniform_int_distribution<int>;
-    static DistType dist;
     DistType::param_type range_;
 };
 
+
+// Reseed the current thread's engine for the lifetime of this object, then put
+// back whatever state it had before.  Lets one task be repeatable without
+// disturbing the random numbers for everything else on that thread.
+class ScopedRandomSeed
+{
+public:
+    explicit ScopedRandomSeed(unsigned int s);
+    ~ScopedRandomSeed();
+
+    ScopedRandomSeed(const ScopedRandomSeed &) = delete;
+    ScopedRandomSeed & operator=(const ScopedRandomSeed &) = delete;
+
+private:
+    std::mt19937 saved_;
+};
+
 #endif
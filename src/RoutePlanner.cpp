@@ -0,0 +1,364 @@
+/*
+    Copyright (C) 2025 by Michael Kristofik <kristo605@gmail.com>
+    Part of the Champions of Anduran project.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    or at your option any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY.
+
+    See the COPYING.txt file for more details.
+*/
+#include "RoutePlanner.h"
+
+#include "DisjointSets.h"
+#include "RandomMap.h"
+#include "terrain.h"
+
+#include <algorithm>
+#include <cassert>
+#include <span>
+#include <tuple>
+#include <utility>
+
+RoutePlanner::RoutePlanner(const RandomMap &rmap, const GameState &state)
+    : rmap_(&rmap),
+    game_(&state),
+    pathfind_(rmap, state),
+    portalTile_(),
+    portalEdges_(),
+    regionPortals_(),
+    tileDist_(rmap.size(), -1),
+    bfsQ_(),
+    frontier_()
+{
+    build_portals();
+    connect_portals();
+}
+
+Path RoutePlanner::find_route(const GameObject &mover, const Hex &hDest)
+{
+    if (mover.hex == hDest || rmap_->offGrid(hDest) || !rmap_->getWalkable(hDest)) {
+        return {};
+    }
+
+    // Nearby destinations don't need the region graph.
+    auto path = pathfind_.find_path(mover, hDest);
+    if (!path.empty()) {
+        return path;
+    }
+
+    const auto tiles = find_portals(mover,
+                                    rmap_->intFromHex(mover.hex),
+                                    rmap_->intFromHex(hDest));
+    if (tiles.empty()) {
+        return {};
+    }
+    return refine(mover, tiles);
+}
+
+int RoutePlanner::num_portals() const
+{
+    return ssize(portalTile_);
+}
+
+void RoutePlanner::build_portals()
+{
+    // Every pair of tiles where you can step from one region to another,
+    // grouped by which regions they join and whether they're on water.
+    struct Crossing
+    {
+        int regionA = -1;
+        int regionB = -1;
+        bool water = false;
+        int tileA = -1;
+        int tileB = -1;
+
+        auto operator<=>(const Crossing &rhs) const = default;
+    };
+    std::vector<Crossing> crossings;
+
+    for (int a = 0; a < rmap_->size(); ++a) {
+        if (!is_open(a)) {
+            continue;
+        }
+        const int regionA = rmap_->getRegion(a);
+        const bool water = rmap_->getTerrain(a) == Terrain::water;
+        for (int b : rmap_->getTileNeighbors(a)) {
+            if (rmap_->getRegion(b) > regionA &&
+                is_open(b) &&
+                (rmap_->getTerrain(b) == Terrain::water) == water)
+            {
+                crossings.push_back({regionA, rmap_->getRegion(b), water, a, b});
+            }
+        }
+    }
+    std::ranges::sort(crossings);
+
+    auto addPortal = [this] (int tile) {
+        const int node = ssize(portalTile_);
+        portalTile_.push_back(tile);
+        regionPortals_.insert(rmap_->getRegion(tile), node);
+        return node;
+    };
+
+    // Obstacles can split a border into several stretches with no way to walk
+    // between them on either side.  Cross each stretch at its middle crossing,
+    // in map order.
+    auto sameBorder = [] (const Crossing &lhs, const Crossing &rhs) {
+        return std::tie(lhs.regionA, lhs.regionB, lhs.water) ==
+            std::tie(rhs.regionA, rhs.regionB, rhs.water);
+    };
+    auto touching = [this] (int a, int b) {
+        return hexDistance(rmap_->hexFromInt(a), rmap_->hexFromInt(b)) <= 1;
+    };
+    for (auto first = begin(crossings); first != end(crossings);) {
+        auto last = std::find_if_not(first, end(crossings), [&] (const Crossing &c) {
+            return sameBorder(c, *first);
+        });
+        const std::span border(first, last);
+
+        DisjointSets stretches(ssize(border));
+        for (int i = 0; i < ssize(border); ++i) {
+            for (int j = i + 1; j < ssize(border); ++j) {
+                if (touching(border[i].tileA, border[j].tileA) ||
+                    touching(border[i].tileB, border[j].tileB))
+                {
+                    stretches.join(i, j);
+                }
+            }
+        }
+
+        std::vector<std::vector<int>> members(ssize(border));
+        for (int i = 0; i < ssize(border); ++i) {
+            members[stretches.find(i)].push_back(i);
+        }
+        for (auto &stretch : members) {
+            if (stretch.empty()) {
+                continue;
+            }
+            const auto &mid = border[stretch[ssize(stretch) / 2]];
+            const int nodeA = addPortal(mid.tileA);
+            const int nodeB = addPortal(mid.tileB);
+            portalEdges_.insert(nodeA, {nodeB, 1});
+            portalEdges_.insert(nodeB, {nodeA, 1});
+        }
+        first = last;
+    }
+
+    regionPortals_.freeze();
+}
+
+void RoutePlanner::connect_portals()
+{
+    for (int region = 0; region < rmap_->numRegions(); ++region) {
+        const auto portals = regionPortals_.find(region);
+        for (int p : portals) {
+            const int tile = portalTile_[p];
+            region_distances(tile, rmap_->getTerrain(tile) == Terrain::water);
+            for (int q : portals) {
+                const int dist = tileDist_[portalTile_[q]];
+                if (q != p && dist >= 0) {
+                    portalEdges_.insert(p, {q, dist});
+                }
+            }
+        }
+    }
+
+    portalEdges_.freeze();
+}
+
+bool RoutePlanner::is_open(int index) const
+{
+    return rmap_->getWalkable(index) && !rmap_->getOccupied(index);
+}
+
+void RoutePlanner::region_distances(int src, bool onWater)
+{
+    // Only the tiles the last search reached need to be reset.
+    for (int tile : bfsQ_) {
+        tileDist_[tile] = -1;
+    }
+    bfsQ_.assign(1, src);
+    tileDist_[src] = 0;
+
+    const int region = rmap_->getRegion(src);
+    for (int head = 0; head < ssize(bfsQ_); ++head) {
+        const int tile = bfsQ_[head];
+        for (int nbr : rmap_->getTileNeighbors(tile)) {
+            if (tileDist_[nbr] < 0 &&
+                is_open(nbr) &&
+                rmap_->getRegion(nbr) == region &&
+                (rmap_->getTerrain(nbr) == Terrain::water) == onWater)
+            {
+                tileDist_[nbr] = tileDist_[tile] + 1;
+                bfsQ_.push_back(nbr);
+            }
+        }
+    }
+}
+
+auto RoutePlanner::endpoint_edges(const GameObject &mover, int index, bool onWater)
+    -> std::vector<EndpointEdge>
+{
+    std::vector<EndpointEdge> edges;
+    auto addEdges = [&] (int from, int extraCost, int via) {
+        region_distances(from, onWater);
+        for (int p : regionPortals_.find(rmap_->getRegion(from))) {
+            const int tile = portalTile_[p];
+            if (tileDist_[tile] >= 0 &&
+                (rmap_->getTerrain(tile) == Terrain::water) == onWater)
+            {
+                edges.push_back({p, tileDist_[tile] + extraCost, via});
+            }
+        }
+    };
+
+    addEdges(index, 0, -1);
+
+    // The first or last step can also cross into a neighboring region.  That
+    // matters for tiles like castles, where every neighbor in the same region
+    // is blocked.
+    const int region = rmap_->getRegion(index);
+    for (int nbr : rmap_->getTileNeighbors(index)) {
+        if (rmap_->getRegion(nbr) != region &&
+            is_open(nbr) &&
+            (rmap_->getTerrain(nbr) == Terrain::water) == onWater &&
+            game_->hex_action(mover, rmap_->hexFromInt(nbr)).action == ObjectAction::none)
+        {
+            addEdges(nbr, 1, nbr);
+        }
+    }
+
+    return edges;
+}
+
+std::vector<int> RoutePlanner::find_portals(const GameObject &mover, int iSrc, int iDest)
+{
+    // The start and end points are extra nodes after all the portals.
+    const int numPortals = ssize(portalTile_);
+    const int start = numPortals;
+    const int goal = numPortals + 1;
+    auto nodeTile = [=, this] (int node) {
+        if (node == start) {
+            return iSrc;
+        }
+        else if (node == goal) {
+            return iDest;
+        }
+        return portalTile_[node];
+    };
+
+    const bool onWater = rmap_->getTerrain(iSrc) == Terrain::water;
+    const auto startEdges = endpoint_edges(mover, iSrc, onWater);
+    const auto goalEdges = endpoint_edges(mover, iDest, onWater);
+
+    // A* over the portals.  Distance to the destination never overestimates
+    // the walking distance, so costs popped from the queue never go down.
+    const auto hDest = rmap_->hexFromInt(iDest);
+    auto estimate = [&] (int node) {
+        return hexDistance(rmap_->hexFromInt(nodeTile(node)), hDest);
+    };
+
+    std::vector<int> costSoFar(numPortals + 2, -1);
+    std::vector<int> cameFrom(numPortals + 2, -1);
+    std::vector<int> viaTile(numPortals + 2, -1);
+    auto relax = [&] (int node, const PortalEdge &edge, int via = -1) {
+        const int newCost = costSoFar[node] + edge.cost;
+        if (costSoFar[edge.to] >= 0 && newCost >= costSoFar[edge.to]) {
+            return;
+        }
+
+        // Anything standing on a portal is in the way.
+        if (edge.to != goal &&
+            portalTile_[edge.to] != iSrc &&
+            game_->hex_action(mover, rmap_->hexFromInt(portalTile_[edge.to])).action !=
+                ObjectAction::none)
+        {
+            return;
+        }
+
+        costSoFar[edge.to] = newCost;
+        cameFrom[edge.to] = node;
+        viaTile[edge.to] = via;
+        frontier_.push({edge.to, newCost + estimate(edge.to)});
+    };
+
+    frontier_.clear();
+    costSoFar[start] = 0;
+    frontier_.push({start, estimate(start)});
+    while (!frontier_.empty()) {
+        const auto current = frontier_.pop();
+        const int node = current.index;
+        if (node == goal) {
+            break;
+        }
+        if (current.cost > costSoFar[node] + estimate(node)) {
+            continue;
+        }
+
+        if (node == start) {
+            for (auto &edge : startEdges) {
+                relax(node, {edge.portal, edge.cost}, edge.via);
+            }
+            continue;
+        }
+
+        for (auto &edge : portalEdges_.find(node)) {
+            relax(node, edge);
+        }
+        for (auto &edge : goalEdges) {
+            if (edge.portal == node) {
+                relax(node, {goal, edge.cost}, edge.via);
+            }
+        }
+    }
+
+    std::vector<int> tiles;
+    if (costSoFar[goal] < 0) {
+        return tiles;
+    }
+    for (int node = goal; node >= 0; node = cameFrom[node]) {
+        tiles.push_back(nodeTile(node));
+        if (viaTile[node] >= 0) {
+            tiles.push_back(viaTile[node]);
+        }
+    }
+    std::ranges::reverse(tiles);
+
+    return tiles;
+}
+
+Path RoutePlanner::refine(const GameObject &mover, const std::vector<int> &tiles)
+{
+    assert(!tiles.empty());
+    Path route = {rmap_->hexFromInt(tiles[0])};
+    GameObject walker = mover;
+
+    for (int i = 1; i < ssize(tiles); ++i) {
+        const int from = tiles[i - 1];
+        const int to = tiles[i];
+        if (from == to) {
+            continue;
+        }
+
+        // Stepping over a border between regions.
+        if (rmap_->getRegion(from) != rmap_->getRegion(to)) {
+            assert(hexDistance(rmap_->hexFromInt(from), rmap_->hexFromInt(to)) == 1);
+            route.push_back(rmap_->hexFromInt(to));
+            continue;
+        }
+
+        // Crossing a region.  This can fail if objects have moved into the way
+        // since the portals were connected.
+        walker.hex = rmap_->hexFromInt(from);
+        const auto leg = pathfind_.find_path(walker, rmap_->hexFromInt(to));
+        if (leg.empty()) {
+            return {};
+        }
+        route.insert(std::end(route), std::begin(leg) + 1, std::end(leg));
+    }
+
+    return route;
+}
@@ -0,0 +1,106 @@
+/*
+    Copyright (C) 2025 by Michael Kristofik <kristo605@gmail.com>
+    Part of the Champions of Anduran project.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    or at your option any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY.
+
+    See the COPYING.txt file for more details.
+*/
+#ifndef ROUTE_PLANNER_H
+#define ROUTE_PLANNER_H
+
+#include "FlatMultimap.h"
+#include "GameState.h"
+#include "Pathfinder.h"
+#include "PriorityQueue.h"
+#include "hex_utils.h"
+
+#include <compare>
+#include <vector>
+
+class RandomMap;
+
+
+// Plan routes that take more than one turn, possibly across the whole map.
+// Searching tile by tile would be too slow on large maps, so this works on two
+// levels.  Each border between regions gets a crossing point in the middle of
+// it, and the walking distances between crossing points in the same region are
+// worked out ahead of time.  A route is first planned from one crossing point
+// to the next, then only the regions along the way are searched tile by tile.
+//
+// Routes aren't always the shortest possible since they have to go through the
+// middle of each border.
+//
+// Each thread should have its own one of these due to internal state.
+class RoutePlanner
+{
+public:
+    RoutePlanner(const RandomMap &rmap, const GameState &state);
+
+    // Return the route to any tile on the map, or empty if there isn't one.
+    Path find_route(const GameObject &mover, const Hex &hDest);
+
+    int num_portals() const;
+
+private:
+    struct PortalEdge
+    {
+        int to = -1;
+        int cost = 0;
+
+        auto operator<=>(const PortalEdge &rhs) const = default;
+    };
+
+    // Connects the start or end of a route to a portal, possibly by way of a
+    // tile in the next region over.
+    struct EndpointEdge
+    {
+        int portal = -1;
+        int cost = 0;
+        int via = -1;
+    };
+
+    // Pick one pair of tiles to cross each border between regions, separately
+    // for land and water.
+    void build_portals();
+
+    // Walking distance between every pair of portals in the same region.
+    void connect_portals();
+
+    // Tiles the map generator put an object on are treated as obstacles ahead
+    // of time.  Objects added later are only found when planning a route.
+    bool is_open(int index) const;
+
+    // Walking distance from 'src' to every open tile in the same region, only
+    // through tiles matching the given terrain.  The start tile doesn't have to
+    // be open or match, so we can route to a boat.  Results go in tileDist_.
+    void region_distances(int src, bool onWater);
+
+    // Portals the mover can walk to from a tile, or from them to the tile.
+    std::vector<EndpointEdge> endpoint_edges(const GameObject &mover,
+                                             int index,
+                                             bool onWater);
+
+    // Search for a list of tiles to pass through: the start point, each portal
+    // along the way, and the end point.
+    std::vector<int> find_portals(const GameObject &mover, int iSrc, int iDest);
+
+    // Fill in the tiles between each pair of portals.
+    Path refine(const GameObject &mover, const std::vector<int> &portals);
+
+    const RandomMap *rmap_;
+    const GameState *game_;
+    Pathfinder pathfind_;
+    std::vector<int> portalTile_;
+    FlatMultimap<int, PortalEdge> portalEdges_;
+    FlatMultimap<int, int> regionPortals_;
+    std::vector<int> tileDist_;
+    std::vector<int> bfsQ_;
+    BucketQueue<EstimatedPathCost> frontier_;
+};
+
+#endif
@@ -0,0 +1,254 @@
+/*
+    Copyright (C) 2025 by Michael Kristofik <kristo605@gmail.com>
+    Part of the Champions of Anduran project.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    or at your option any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY.
+
+    See the COPYING.txt file for more details.
+*/
+#ifndef TILE_BITSET_H
+#define TILE_BITSET_H
+
+#include <bit>
+#include <cassert>
+#include <cstdint>
+#include <ranges>
+#include <span>
+#include <vector>
+
+// One bit per tile, packed 64 to a word.  Meant for the yes/no attributes of
+// every tile on the map (obstacle, walkable, etc.).  Whole-map queries such as
+// "walkable and not occupied" work a word at a time, and iterating over the set
+// bits skips empty words entirely.
+//
+// Bits past the last tile are always zero so that counting and iterating never
+// see them.
+class TileBitset
+{
+public:
+    TileBitset();
+    explicit TileBitset(int size, bool value = false);
+
+    // Convert from a sequence of integer flags, nonzero means set.
+    template <std::ranges::input_range R>
+    explicit TileBitset(const R &flags);
+
+    // Restore from the packed words saved by words().
+    TileBitset(int size, std::span<const uint64_t> words);
+
+    int size() const;
+    bool empty() const;
+
+    bool operator[](int index) const;
+    void set(int index);
+    void reset(int index);
+    void assign(int index, bool value);
+
+    // Number of set bits in the whole map, or among the given tiles.
+    int count() const;
+    template <std::ranges::input_range R>
+    int count(const R &tiles) const;
+
+    // Word-level operations on two bitsets of the same size.
+    TileBitset & operator&=(const TileBitset &rhs);
+    TileBitset & operator|=(const TileBitset &rhs);
+    TileBitset & andNot(const TileBitset &rhs);  // this &= ~rhs
+    TileBitset & flip();
+
+    // Call func(index) for every set bit, in increasing index order.
+    template <typename F>
+    void forEachSet(F func) const;
+
+    // Expand back to one flag per tile, for writing to a file.
+    std::vector<signed char> toVector() const;
+    std::span<const uint64_t> words() const;
+
+    friend TileBitset operator&(TileBitset lhs, const TileBitset &rhs);
+    friend TileBitset operator|(TileBitset lhs, const TileBitset &rhs);
+
+private:
+    static constexpr int bitsPerWord = 64;
+
+    void clearPadding();
+
+    std::vector<uint64_t> words_;
+    int size_;
+};
+
+
+inline TileBitset::TileBitset()
+    : words_(),
+    size_(0)
+{
+}
+
+inline TileBitset::TileBitset(int size, bool value)
+    : words_((size + bitsPerWord - 1) / bitsPerWord, value ? ~uint64_t{0} : 0),
+    size_(size)
+{
+    clearPadding();
+}
+
+template <std::ranges::input_range R>
+TileBitset::TileBitset(const R &flags)
+    : TileBitset(std::ranges::distance(flags))
+{
+    int i = 0;
+    for (const auto &f : flags) {
+        if (f) {
+            set(i);
+        }
+        ++i;
+    }
+}
+
+inline TileBitset::TileBitset(int size, std::span<const uint64_t> words)
+    : words_(std::begin(words), std::end(words)),
+    size_(size)
+{
+    assert(std::ssize(words_) == (size + bitsPerWord - 1) / bitsPerWord);
+    clearPadding();
+}
+
+inline int TileBitset::size() const
+{
+    return size_;
+}
+
+inline bool TileBitset::empty() const
+{
+    return size_ == 0;
+}
+
+inline bool TileBitset::operator[](int index) const
+{
+    assert(index >= 0 && index < size_);
+    return (words_[index / bitsPerWord] >> (index % bitsPerWord)) & 1;
+}
+
+inline void TileBitset::set(int index)
+{
+    assert(index >= 0 && index < size_);
+    words_[index / bitsPerWord] |= uint64_t{1} << (index % bitsPerWord);
+}
+
+inline void TileBitset::reset(int index)
+{
+    assert(index >= 0 && index < size_);
+    words_[index / bitsPerWord] &= ~(uint64_t{1} << (index % bitsPerWord));
+}
+
+inline void TileBitset::assign(int index, bool value)
+{
+    if (value) {
+        set(index);
+    }
+    else {
+        reset(index);
+    }
+}
+
+inline int TileBitset::count() const
+{
+    int total = 0;
+    for (auto w : words_) {
+        total += std::popcount(w);
+    }
+    return total;
+}
+
+template <std::ranges::input_range R>
+int TileBitset::count(const R &tiles) const
+{
+    int total = 0;
+    for (int t : tiles) {
+        total += (*this)[t];
+    }
+    return total;
+}
+
+inline TileBitset & TileBitset::operator&=(const TileBitset &rhs)
+{
+    assert(size_ == rhs.size_);
+    for (int i = 0; i < std::ssize(words_); ++i) {
+        words_[i] &= rhs.words_[i];
+    }
+    return *this;
+}
+
+inline TileBitset & TileBitset::operator|=(const TileBitset &rhs)
+{
+    assert(size_ == rhs.size_);
+    for (int i = 0; i < std::ssize(words_); ++i) {
+        words_[i] |= rhs.words_[i];
+    }
+    return *this;
+}
+
+inline TileBitset & TileBitset::andNot(const TileBitset &rhs)
+{
+    assert(size_ == rhs.size_);
+    for (int i = 0; i < std::ssize(words_); ++i) {
+        words_[i] &= ~rhs.words_[i];
+    }
+    return *this;
+}
+
+inline TileBitset & TileBitset::flip()
+{
+    for (auto &w : words_) {
+        w = ~w;
+    }
+    clearPadding();
+    return *this;
+}
+
+template <typename F>
+void TileBitset::forEachSet(F func) const
+{
+    for (int i = 0; i < std::ssize(words_); ++i) {
+        auto w = words_[i];
+        while (w != 0) {
+            func(i * bitsPerWord + std::countr_zero(w));
+            w &= w - 1;  // clear the lowest set bit
+        }
+    }
+}
+
+inline std::vector<signed char> TileBitset::toVector() const
+{
+    std::vector<signed char> flags(size_, 0);
+    forEachSet([&flags] (int index) { flags[index] = 1; });
+    return flags;
+}
+
+inline std::span<const uint64_t> TileBitset::words() const
+{
+    return words_;
+}
+
+inline void TileBitset::clearPadding()
+{
+    const int extra = size_ % bitsPerWord;
+    if (extra > 0) {
+        words_.back() &= (uint64_t{1} << extra) - 1;
+    }
+}
+
+inline TileBitset operator&(TileBitset lhs, const TileBitset &rhs)
+{
+    lhs &= rhs;
+    return lhs;
+}
+
+inline TileBitset operator|(TileBitset lhs, const TileBitset &rhs)
+{
+    lhs |= rhs;
+    return lhs;
+}
+
+#endif
@@ -0,0 +1,107 @@
+/*
+    Copyright (C) 2025 by Michael Kristofik <kristo605@gmail.com>
+    Part of the Champions of Anduran project.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    or at your option any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY.
+
+    See the COPYING.txt file for more details.
+*/
+// Link this file into a program to count its heap allocations (see
+// profile_utils.h).  It replaces the global operator new and delete.  Each
+// block gets a small header recording its size so delete knows how much is
+// being freed.  Over-aligned allocations aren't counted.
+
+#include "profile_utils.h"
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+    constexpr std::size_t HEADER_SIZE = alignof(std::max_align_t);
+
+    [[maybe_unused]] const bool enabled = (alloc_enable_tracking(), true);
+
+    void * tracked_alloc(std::size_t size) noexcept
+    {
+        void *block = std::malloc(size + HEADER_SIZE);
+        if (!block) {
+            return nullptr;
+        }
+
+        *static_cast<std::size_t *>(block) = size;
+        alloc_record_new(size);
+        return static_cast<char *>(block) + HEADER_SIZE;
+    }
+
+    void tracked_free(void *ptr) noexcept
+    {
+        if (!ptr) {
+            return;
+        }
+
+        void *block = static_cast<char *>(ptr) - HEADER_SIZE;
+        alloc_record_delete(*static_cast<std::size_t *>(block));
+        std::free(block);
+    }
+}
+
+
+void * operator new(std::size_t size)
+{
+    void *ptr = tracked_alloc(size);
+    if (!ptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void * operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void * operator new(std::size_t size, const std::nothrow_t &) noexcept
+{
+    return tracked_alloc(size);
+}
+
+void * operator new[](std::size_t size, const std::nothrow_t &) noexcept
+{
+    return tracked_alloc(size);
+}
+
+void operator delete(void *ptr) noexcept
+{
+    tracked_free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept
+{
+    tracked_free(ptr);
+}
+
+void operator delete(void *ptr, std::size_t) noexcept
+{
+    tracked_free(ptr);
+}
+
+void operator delete[](void *ptr, std::size_t) noexcept
+{
+    tracked_free(ptr);
+}
+
+void operator delete(void *ptr, const std::nothrow_t &) noexcept
+{
+    tracked_free(ptr);
+}
+
+void operator delete[](void *ptr, const std::nothrow_t &) noexcept
+{
+    tracked_free(ptr);
+}
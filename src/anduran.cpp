@@ -34,12 +34,12 @@ namespace
 }
 
 
-Anduran::Anduran()
+Anduran::Anduran(const MapArgs &mapArgs)
     : SdlApp(),
     config_("data/window.json"s),
     win_(config_.width(), config_.height(), "Champions of Anduran"),
     objConfig_("data/objects.json"s),
-    rmap_("test.json", objConfig_),
+    rmap_(load_map(mapArgs, "test.json", objConfig_)),
     images_("img/"s),
     objImg_(images_, objConfig_, win_),
     puzzleArt_(images_),
@@ -57,11 +57,15 @@ Anduran::Anduran()
     pendingDefeat_(-1),
     curPath_(),
     hCurPathEnd_(),
+    noRoute_(),
+    noRouteEntity_(-1),
+    noRouteVersion_(0),
     projectileId_(-1),
     hpBarIds_(),
     boatFloorIds_(),
     anims_(),
     pathfind_(rmap_, game_),
+    planner_(rmap_, game_),
     units_("data/units.json"s, win_, images_),
     stateChanged_(true),
     influence_(rmap_.numRegions()),
@@ -284,19 +288,51 @@ void Anduran::handle_mouse_pos(Uint32 elapsed_ms)
     }
 
     // Draw the path to the highlighted hex, unless the champion doesn't have
-    // enough movement left to reach it.
+    // enough movement left to reach it.  Everywhere the champion can reach is
+    // computed once and reused until something changes.
     rmapView_.clearPath();
     auto champion = game_.get_object(curChampion_);
-    curPath_ = pathfind_.find_path(champion, hCurPathEnd_);
+    pathfind_.find_reachable(champion, champions_[curChampion_].movesLeft, terrainCost);
+    curPath_ = pathfind_.reachable_path(hCurPathEnd_);
     if (!curPath_.empty()) {
-        if (champions_[curChampion_].movesLeft >= movement_cost(curPath_)) {
-            auto [action, _] = game_.hex_action(champion, hCurPathEnd_);
-            rmapView_.showPath(curPath_, action);
-        }
-        else {
-            curPath_.clear();
-        }
+        auto [action, _] = game_.hex_action(champion, hCurPathEnd_);
+        rmapView_.showPath(curPath_, action);
+        return;
+    }
+
+    // Too far to get there this turn.  Show the whole route, but only move as
+    // far along it as the champion can for now.  Planning a route can search
+    // much of the map, so don't ask again for somewhere it already failed.
+    if (rmap_.offGrid(hCurPathEnd_) || !rmap_.getWalkable(hCurPathEnd_)) {
+        return;
+    }
+    if (noRouteEntity_ != curChampion_ || noRouteVersion_ != game_.version()) {
+        noRoute_ = TileBitset(rmap_.size());
+        noRouteEntity_ = curChampion_;
+        noRouteVersion_ = game_.version();
+    }
+    const int iDest = rmap_.intFromHex(hCurPathEnd_);
+    if (noRoute_[iDest]) {
+        return;
+    }
+
+    auto route = planner_.find_route(champion, hCurPathEnd_);
+    if (route.empty()) {
+        noRoute_.set(iDest);
+        return;
+    }
+
+    auto stopHere = std::find_if(std::rbegin(route), std::rend(route),
+                                 [this] (const Hex &hex) {
+                                     return pathfind_.reachable_cost(hex) >= 0;
+                                 });
+    if (stopHere != std::rend(route)) {
+        curPath_ = pathfind_.reachable_path(*stopHere);
+        route.erase(std::begin(route), stopHere.base());
+        route.insert(std::begin(route), std::begin(curPath_), std::end(curPath_));
     }
+    auto [action, _] = game_.hex_action(champion, hCurPathEnd_);
+    rmapView_.showPath(route, action);
 }
 
 void Anduran::handle_key_up(const SDL_Keysym &key)
@@ -1408,8 +1444,9 @@ void Anduran::check_victory_condition()
 }
 
 
-int main(int, char *[])  // two-argument form required by SDL
+// usage: anduran [-s seed [-w width]]
+int main(int argc, char *argv[])
 {
-    Anduran app;
+    Anduran app(parse_map_args(argc, argv));
     return app.run();
 }
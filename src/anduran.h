@@ -16,6 +16,7 @@
 #include "AnimQueue.h"
 #include "ChampionDisplay.h"
 #include "GameState.h"
+#include "MapCache.h"
 #include "MapDisplay.h"
 #include "Minimap.h"
 #include "ObjectImages.h"
@@ -24,10 +25,12 @@
 #include "PuzzleDisplay.h"
 #include "PuzzleState.h"
 #include "RandomMap.h"
+#include "RoutePlanner.h"
 #include "SdlApp.h"
 #include "SdlImageManager.h"
 #include "SdlTexture.h"
 #include "SdlWindow.h"
+#include "TileBitset.h"
 #include "UnitManager.h"
 #include "WindowConfig.h"
 #include "battle_utils.h"
@@ -67,7 +70,7 @@ struct Player
 class Anduran : public SdlApp
 {
 public:
-    Anduran();
+    explicit Anduran(const MapArgs &mapArgs);
 
 private:
     void update_frame(Uint32 elapsed_ms) override;
@@ -153,11 +156,17 @@ private:
     int pendingDefeat_;  // defeated champion not yet removed from sidebar
     Path curPath_;
     Hex hCurPathEnd_;
+    // Hexes the route planner couldn't reach for the current champion, until
+    // the game state changes.
+    TileBitset noRoute_;
+    int noRouteEntity_;
+    unsigned int noRouteVersion_;
     int projectileId_;
     std::array<int, 2> hpBarIds_;
     std::array<int, 2> boatFloorIds_;
     AnimQueue anims_;
     Pathfinder pathfind_;
+    RoutePlanner planner_;
     UnitManager units_;
     bool stateChanged_;
     std::vector<EnumSizedArray<int, Team>> influence_;
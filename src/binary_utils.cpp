@@ -0,0 +1,392 @@
+/*
+    Copyright (C) 2025 by Michael Kristofik <kristo605@gmail.com>
+    Part of the Champions of Anduran project.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    or at your option any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY.
+
+    See the COPYING.txt file for more details.
+*/
+#include "binary_utils.h"
+#include "log_utils.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstdio>
+#include <memory>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    struct FileHeader
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t numSections;
+    };
+
+    struct SectionEntry
+    {
+        uint32_t id;
+        uint32_t elemSize;
+        uint64_t offset;
+        uint64_t count;
+    };
+
+    static_assert(sizeof(FileHeader) == 16);
+    static_assert(sizeof(SectionEntry) == 24);
+
+    const uint64_t SECTION_ALIGN = 8;
+
+    uint64_t align_up(uint64_t offset)
+    {
+        return (offset + SECTION_ALIGN - 1) / SECTION_ALIGN * SECTION_ALIGN;
+    }
+
+    // We write the arrays exactly as they are in memory.
+    void check_endian(const char *filename)
+    {
+        if constexpr (std::endian::native != std::endian::little) {
+            auto msg = std::format("{}: binary files need a little-endian machine",
+                                   filename);
+            log_error(msg);
+            throw std::runtime_error(msg);
+        }
+    }
+
+    [[noreturn]] void throw_error(const std::string &msg)
+    {
+        log_error(msg);
+        throw std::runtime_error(msg);
+    }
+
+    // Where each section's data goes, and the total file size.
+    std::vector<SectionEntry> layout_sections(
+        std::span<const BinaryStreamWriter::SectionSize> sections,
+        uint64_t &fileSize)
+    {
+        std::vector<SectionEntry> table;
+        uint64_t offset = sizeof(FileHeader) + sections.size() * sizeof(SectionEntry);
+        for (auto &s : sections) {
+            offset = align_up(offset);
+            table.push_back({s.id, s.elemSize, offset, s.count});
+            offset += s.count * s.elemSize;
+        }
+
+        fileSize = offset;
+        return table;
+    }
+
+    void seek_to(FILE *file, uint64_t offset)
+    {
+#ifdef _WIN32
+        _fseeki64(file, offset, SEEK_SET);
+#else
+        fseeko(file, offset, SEEK_SET);
+#endif
+    }
+}
+
+
+#ifdef _WIN32
+MappedFile::MappedFile(const char *filename)
+    : data_(nullptr),
+    size_(0),
+    fileHandle_(INVALID_HANDLE_VALUE),
+    mapHandle_(nullptr)
+{
+    fileHandle_ = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, nullptr,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (fileHandle_ == INVALID_HANDLE_VALUE) {
+        throw_error(std::format("couldn't open file: {}", filename));
+    }
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(fileHandle_, &fileSize)) {
+        CloseHandle(fileHandle_);
+        throw_error(std::format("couldn't get file size: {}", filename));
+    }
+    size_ = fileSize.QuadPart;
+    if (size_ == 0) {
+        return;  // can't map an empty file
+    }
+
+    mapHandle_ = CreateFileMappingA(fileHandle_, nullptr, PAGE_READONLY, 0, 0,
+                                    nullptr);
+    if (mapHandle_) {
+        data_ = static_cast<const std::byte *>(
+            MapViewOfFile(mapHandle_, FILE_MAP_READ, 0, 0, 0));
+    }
+    if (!data_) {
+        if (mapHandle_) {
+            CloseHandle(mapHandle_);
+        }
+        CloseHandle(fileHandle_);
+        throw_error(std::format("couldn't map file: {}", filename));
+    }
+}
+
+MappedFile::~MappedFile()
+{
+    if (data_) {
+        UnmapViewOfFile(data_);
+    }
+    if (mapHandle_) {
+        CloseHandle(mapHandle_);
+    }
+    CloseHandle(fileHandle_);
+}
+#else
+MappedFile::MappedFile(const char *filename)
+    : data_(nullptr),
+    size_(0)
+{
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        throw_error(std::format("couldn't open file: {}", filename));
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        close(fd);
+        throw_error(std::format("couldn't get file size: {}", filename));
+    }
+    size_ = info.st_size;
+    if (size_ == 0) {
+        close(fd);
+        return;  // can't map an empty file
+    }
+
+    // The mapping stays valid after the file is closed.
+    void *addr = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+        throw_error(std::format("couldn't map file: {}", filename));
+    }
+    data_ = static_cast<const std::byte *>(addr);
+}
+
+MappedFile::~MappedFile()
+{
+    if (data_) {
+        munmap(const_cast<std::byte *>(data_), size_);
+    }
+}
+#endif
+
+std::span<const std::byte> MappedFile::data() const
+{
+    return {data_, size_};
+}
+
+
+BinaryFileWriter::BinaryFileWriter(const BinaryMagic &magic, uint32_t version)
+    : magic_(),
+    version_(version),
+    sections_()
+{
+    std::ranges::copy(magic, magic_);
+}
+
+void BinaryFileWriter::write(const char *filename) const
+{
+    check_endian(filename);
+
+    FileHeader header;
+    std::ranges::copy(magic_, header.magic);
+    header.version = version_;
+    header.numSections = sections_.size();
+
+    // Lay out the section data after the table.
+    std::vector<BinaryStreamWriter::SectionSize> sizes;
+    for (auto &s : sections_) {
+        sizes.push_back({s.id, s.elemSize, s.count});
+    }
+    uint64_t fileSize = 0;
+    const auto table = layout_sections(sizes, fileSize);
+
+    std::vector<std::byte> buf(fileSize, std::byte{0});
+    std::memcpy(buf.data(), &header, sizeof(header));
+    if (!table.empty()) {
+        std::memcpy(buf.data() + sizeof(header), table.data(),
+                    table.size() * sizeof(SectionEntry));
+    }
+    for (size_t i = 0; i < sections_.size(); ++i) {
+        std::ranges::copy(sections_[i].bytes, buf.begin() + table[i].offset);
+    }
+
+    std::unique_ptr<FILE, decltype(&fclose)> file(fopen(filename, "wb"), fclose);
+    if (!file) {
+        throw_error(std::format("couldn't open file for writing: {}", filename));
+    }
+    if (fwrite(buf.data(), 1, buf.size(), file.get()) != buf.size()) {
+        throw_error(std::format("couldn't write file: {}", filename));
+    }
+}
+
+
+BinaryStreamWriter::BinaryStreamWriter(const char *filename,
+                                       const BinaryMagic &magic,
+                                       uint32_t version,
+                                       std::span<const SectionSize> sections)
+    : filename_(filename),
+    file_(fopen(filename, "wb"), fclose),
+    sections_()
+{
+    check_endian(filename);
+    if (!file_) {
+        throw_error(std::format("couldn't open file for writing: {}", filename));
+    }
+
+    FileHeader header;
+    std::ranges::copy(magic, header.magic);
+    header.version = version;
+    header.numSections = sections.size();
+
+    uint64_t fileSize = 0;
+    const auto table = layout_sections(sections, fileSize);
+    for (size_t i = 0; i < sections.size(); ++i) {
+        sections_.push_back({sections[i], table[i].offset, 0});
+    }
+
+    // Write the last byte first so the file is its full size from the start.
+    // Padding between sections reads back as zeros.
+    bool ok = fwrite(&header, sizeof(header), 1, file_.get()) == 1;
+    if (!table.empty()) {
+        ok = ok && fwrite(table.data(), sizeof(SectionEntry), table.size(),
+                          file_.get()) == table.size();
+    }
+    if (fileSize > sizeof(header) + table.size() * sizeof(SectionEntry)) {
+        const char zero = 0;
+        seek_to(file_.get(), fileSize - 1);
+        ok = ok && fwrite(&zero, 1, 1, file_.get()) == 1;
+    }
+    if (!ok) {
+        throw_error(std::format("couldn't write file: {}", filename));
+    }
+}
+
+void BinaryStreamWriter::appendBytes(uint32_t id,
+                                     uint32_t elemSize,
+                                     const void *data,
+                                     uint64_t count)
+{
+    auto iter = std::ranges::find(sections_, id, [] (auto &c) { return c.size.id; });
+    if (iter == std::end(sections_)) {
+        throw_error(std::format("{}: section {} wasn't declared", filename_, id));
+    }
+    if (iter->size.elemSize != elemSize) {
+        throw_error(std::format("{}: section {} has the wrong element size",
+                                filename_, id));
+    }
+    if (iter->written + count > iter->size.count) {
+        throw_error(std::format("{}: section {} is too big", filename_, id));
+    }
+    if (count == 0) {
+        return;
+    }
+
+    seek_to(file_.get(), iter->offset + iter->written * elemSize);
+    if (fwrite(data, elemSize, count, file_.get()) != count) {
+        throw_error(std::format("couldn't write file: {}", filename_));
+    }
+    iter->written += count;
+}
+
+void BinaryStreamWriter::finish()
+{
+    for (auto &c : sections_) {
+        if (c.written != c.size.count) {
+            throw_error(std::format("{}: section {} has {} of {} elements",
+                                    filename_, c.size.id, c.written, c.size.count));
+        }
+    }
+
+    // Flush now so a failed write isn't lost when the file closes.
+    if (fflush(file_.get()) != 0) {
+        throw_error(std::format("couldn't write file: {}", filename_));
+    }
+    file_.reset();
+}
+
+
+BinaryFileReader::BinaryFileReader(const char *filename,
+                                   const BinaryMagic &magic,
+                                   uint32_t version)
+    : filename_(filename),
+    file_(filename),
+    sections_()
+{
+    check_endian(filename);
+
+    auto data = file_.data();
+    FileHeader header;
+    if (data.size() < sizeof(header)) {
+        throw_error(std::format("{}: file too short", filename));
+    }
+    std::memcpy(&header, data.data(), sizeof(header));
+    if (!std::ranges::equal(header.magic, magic)) {
+        throw_error(std::format("{}: wrong file type", filename));
+    }
+    if (header.version != version) {
+        throw_error(std::format("{}: version {} not supported (expected {})",
+                                filename, header.version, version));
+    }
+
+    const auto tableEnd = sizeof(header) +
+        static_cast<uint64_t>(header.numSections) * sizeof(SectionEntry);
+    if (tableEnd > data.size()) {
+        throw_error(std::format("{}: section table truncated", filename));
+    }
+
+    for (uint32_t i = 0; i < header.numSections; ++i) {
+        SectionEntry entry;
+        std::memcpy(&entry, data.data() + sizeof(header) + i * sizeof(entry),
+                    sizeof(entry));
+
+        // Divide rather than multiply so a huge count can't wrap around.
+        if (entry.elemSize == 0 ||
+            entry.offset % SECTION_ALIGN != 0 ||
+            entry.offset > data.size() ||
+            entry.count > (data.size() - entry.offset) / entry.elemSize)
+        {
+            throw_error(std::format("{}: section {} out of bounds", filename, entry.id));
+        }
+
+        const uint64_t numBytes = entry.count * entry.elemSize;
+        SectionView view{entry.elemSize, data.subspan(entry.offset, numBytes)};
+        sections_.emplace_back(entry.id, view);
+    }
+}
+
+bool BinaryFileReader::matches(const char *filename, const BinaryMagic &magic)
+{
+    std::unique_ptr<FILE, decltype(&fclose)> file(fopen(filename, "rb"), fclose);
+    if (!file) {
+        return false;
+    }
+
+    char buf[sizeof(BinaryMagic)];
+    return fread(buf, 1, sizeof(buf), file.get()) == sizeof(buf) &&
+        std::ranges::equal(buf, magic);
+}
+
+BinaryFileReader::SectionView BinaryFileReader::findSection(uint32_t id) const
+{
+    auto iter = std::ranges::find(sections_, id, &decltype(sections_)::value_type::first);
+    if (iter == std::end(sections_)) {
+        return {0, {}};
+    }
+    return iter->second;
+}
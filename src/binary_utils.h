@@ -0,0 +1,212 @@
+/*
+    Copyright (C) 2025 by Michael Kristofik <kristo605@gmail.com>
+    Part of the Champions of Anduran project.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    or at your option any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY.
+
+    See the COPYING.txt file for more details.
+*/
+#ifndef BINARY_UTILS_H
+#define BINARY_UTILS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <format>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// Read-only view of an entire file, mapped into memory.  Throws
+// std::runtime_error if the file can't be opened.
+class MappedFile
+{
+public:
+    explicit MappedFile(const char *filename);
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile & operator=(const MappedFile &) = delete;
+
+    std::span<const std::byte> data() const;
+
+private:
+    const std::byte *data_;
+    std::size_t size_;
+#ifdef _WIN32
+    void *fileHandle_;
+    void *mapHandle_;
+#endif
+};
+
+
+// Simple container for binary files: an 8-byte magic string and version number,
+// a table of sections, then each section as an array of fixed-width
+// little-endian values.  Sections start on 8-byte boundaries so they can be used
+// in place once the file is mapped into memory.
+//
+// layout:
+//     char magic[8]
+//     uint32_t version
+//     uint32_t numSections
+//     numSections * {uint32_t id, uint32_t elemSize, uint64_t offset, uint64_t count}
+//     section data
+using BinaryMagic = char[8];
+
+// Element types must be plain data with no padding.
+template <typename T>
+concept BinaryElement = std::is_trivially_copyable_v<T> &&
+    std::has_unique_object_representations_v<T>;
+
+class BinaryFileWriter
+{
+public:
+    BinaryFileWriter(const BinaryMagic &magic, uint32_t version);
+
+    template <BinaryElement T>
+    void addSection(uint32_t id, std::span<const T> elems);
+
+    // Throws std::runtime_error on failure.
+    void write(const char *filename) const;
+
+private:
+    struct Section
+    {
+        uint32_t id;
+        uint32_t elemSize;
+        uint64_t count;
+        std::vector<std::byte> bytes;
+    };
+
+    BinaryMagic magic_;
+    uint32_t version_;
+    std::vector<Section> sections_;
+};
+
+
+// Same file layout, for files too big to build in memory first.  Every
+// section's size is declared up front, then each one is filled in a piece at a
+// time, in any interleaving.
+class BinaryStreamWriter
+{
+public:
+    struct SectionSize
+    {
+        uint32_t id;
+        uint32_t elemSize;
+        uint64_t count;
+    };
+
+    template <BinaryElement T>
+    static SectionSize sectionSize(uint32_t id, uint64_t count);
+
+    // Throws std::runtime_error if the file can't be created.
+    BinaryStreamWriter(const char *filename,
+                       const BinaryMagic &magic,
+                       uint32_t version,
+                       std::span<const SectionSize> sections);
+
+    // Add elements to the end of what's been written to a section so far.
+    // Throws std::runtime_error if that would overflow its declared size.
+    template <BinaryElement T>
+    void append(uint32_t id, std::span<const T> elems);
+
+    // Throws std::runtime_error if any section isn't full or the file couldn't
+    // be written.
+    void finish();
+
+private:
+    struct Cursor
+    {
+        SectionSize size;
+        uint64_t offset;
+        uint64_t written;
+    };
+
+    void appendBytes(uint32_t id, uint32_t elemSize, const void *data, uint64_t count);
+
+    std::string filename_;
+    std::unique_ptr<FILE, decltype(&fclose)> file_;
+    std::vector<Cursor> sections_;
+};
+
+
+class BinaryFileReader
+{
+public:
+    // Throws std::runtime_error if the file is missing, isn't the right type, or
+    // has a different version.
+    BinaryFileReader(const char *filename,
+                     const BinaryMagic &magic,
+                     uint32_t version);
+
+    // Return true if the file starts with the given magic string.
+    static bool matches(const char *filename, const BinaryMagic &magic);
+
+    // Return a view of a section's elements straight out of the mapped file, or
+    // an empty span if the file doesn't have that section.  Only valid for the
+    // lifetime of this object.
+    template <BinaryElement T>
+    std::span<const T> section(uint32_t id) const;
+
+private:
+    struct SectionView
+    {
+        uint32_t elemSize;
+        std::span<const std::byte> bytes;
+    };
+
+    SectionView findSection(uint32_t id) const;
+
+    std::string filename_;
+    MappedFile file_;
+    std::vector<std::pair<uint32_t, SectionView>> sections_;
+};
+
+
+template <BinaryElement T>
+void BinaryFileWriter::addSection(uint32_t id, std::span<const T> elems)
+{
+    Section s{id, sizeof(T), elems.size(), std::vector<std::byte>(elems.size_bytes())};
+    if (!elems.empty()) {
+        std::memcpy(s.bytes.data(), elems.data(), elems.size_bytes());
+    }
+    sections_.push_back(std::move(s));
+}
+
+template <BinaryElement T>
+BinaryStreamWriter::SectionSize BinaryStreamWriter::sectionSize(uint32_t id, uint64_t count)
+{
+    return {id, sizeof(T), count};
+}
+
+template <BinaryElement T>
+void BinaryStreamWriter::append(uint32_t id, std::span<const T> elems)
+{
+    appendBytes(id, sizeof(T), elems.data(), elems.size());
+}
+
+template <BinaryElement T>
+std::span<const T> BinaryFileReader::section(uint32_t id) const
+{
+    auto s = findSection(id);
+    if (s.bytes.empty()) {
+        return {};
+    }
+    if (s.elemSize != sizeof(T) || s.bytes.size() % sizeof(T) != 0) {
+        throw std::runtime_error(std::format("{}: section {} has the wrong element size",
+                                             filename_, id));
+    }
+
+    return {reinterpret_cast<const T *>(s.bytes.data()), s.bytes.size() / sizeof(T)};
+}
+
+#endif
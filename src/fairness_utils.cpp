@@ -0,0 +1,213 @@
+/*
+    Copyright (C) 2025 by Michael Kristofik <kristo605@gmail.com>
+    Part of the Champions of Anduran project.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    or at your option any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY.
+
+    See the COPYING.txt file for more details.
+*/
+#include "fairness_utils.h"
+
+#include "ObjectManager.h"
+#include "RandomRange.h"
+#include "thread_utils.h"
+
+#include <algorithm>
+#include <cassert>
+#include <mutex>
+#include <numeric>
+#include <optional>
+#include <tuple>
+
+namespace
+{
+    // How many of the nearest objects of each type count toward distance.
+    const int NEAREST_OBJECTS = 3;
+
+    // A tile is contested if a rival castle is at most this much farther away.
+    const int CONTEST_MARGIN = 2;
+
+    const ObjectType SCORED_OBJECTS[] = {
+        ObjectType::village,
+        ObjectType::obelisk,
+        ObjectType::chest
+    };
+
+    // Relative spread of one measure across all castles.
+    template <typename F>
+    double spread(const std::vector<CastleShare> &castles, F getValue)
+    {
+        assert(!castles.empty());
+        double lowest = getValue(castles[0]);
+        double highest = lowest;
+        double total = 0.0;
+        for (auto &c : castles) {
+            const double value = getValue(c);
+            lowest = std::min(lowest, value);
+            highest = std::max(highest, value);
+            total += value;
+        }
+
+        // Avoid blowing up when every castle has (close to) none of something.
+        const double mean = total / castles.size();
+        return (highest - lowest) / std::max(mean, 1.0);
+    }
+
+    double & object_count(CastleShare &share, ObjectType type)
+    {
+        switch (type) {
+            case ObjectType::village:
+                return share.villages;
+            case ObjectType::obelisk:
+                return share.obelisks;
+            default:
+                assert(type == ObjectType::chest);
+                return share.chests;
+        }
+    }
+}
+
+
+MapFairness map_fairness(RandomMap &rmap)
+{
+    MapFairness fairness;
+    const auto castleHexes = rmap.getCastleTiles();
+    const int numCastles = ssize(castleHexes);
+    if (numCastles == 0) {
+        return fairness;
+    }
+
+    // Anything a castle can't reach on foot counts as very far away.
+    const int unreachable = rmap.width() * 2;
+
+    std::vector<std::vector<int>> dist;
+    for (auto &hex : castleHexes) {
+        auto &share = fairness.castles.emplace_back();
+        share.tile = rmap.intFromHex(hex);
+        const int src[] = {share.tile};
+        dist.push_back(rmap.walkingDistanceField(src));
+    }
+    auto walk = [&dist, unreachable] (int castle, int tile) {
+        const int d = dist[castle][tile];
+        return d < 0 ? unreachable : d;
+    };
+
+    for (auto type : SCORED_OBJECTS) {
+        std::vector<std::vector<int>> objDist(numCastles);
+        for (int tile : rmap.getObjectTiles(type)) {
+            int nearest = unreachable;
+            for (int c = 0; c < numCastles; ++c) {
+                objDist[c].push_back(walk(c, tile));
+                nearest = std::min(nearest, objDist[c].back());
+            }
+            if (nearest == unreachable) {
+                continue;
+            }
+
+            // Whoever is closest gets credit for the object.
+            const auto numClosest = std::ranges::count_if(objDist,
+                [nearest] (auto &d) { return d.back() == nearest; });
+            for (int c = 0; c < numCastles; ++c) {
+                if (objDist[c].back() == nearest) {
+                    object_count(fairness.castles[c], type) += 1.0 / numClosest;
+                }
+            }
+        }
+
+        for (int c = 0; c < numCastles; ++c) {
+            auto &d = objDist[c];
+            d.resize(std::max<int>(ssize(d), NEAREST_OBJECTS), unreachable);
+            std::ranges::partial_sort(d, begin(d) + NEAREST_OBJECTS);
+            const double total = std::accumulate(begin(d), begin(d) + NEAREST_OBJECTS, 0.0);
+            fairness.castles[c].objectDistance += total / NEAREST_OBJECTS;
+        }
+    }
+    for (auto &share : fairness.castles) {
+        share.objectDistance /= std::size(SCORED_OBJECTS);
+    }
+
+    for (int c = 0; c < numCastles; ++c) {
+        auto &share = fairness.castles[c];
+        share.rivalDistance = unreachable;
+        for (int other = 0; other < numCastles; ++other) {
+            if (other != c) {
+                share.rivalDistance = std::min(share.rivalDistance,
+                                               walk(c, fairness.castles[other].tile));
+            }
+        }
+    }
+
+    // Credit each tile to the nearest castle(s), and note whether a rival is
+    // almost as close.
+    for (int tile = 0; tile < rmap.size(); ++tile) {
+        int nearest = unreachable;
+        for (int c = 0; c < numCastles; ++c) {
+            nearest = std::min(nearest, walk(c, tile));
+        }
+        if (nearest == unreachable) {
+            continue;
+        }
+
+        int numNear = 0;
+        for (int c = 0; c < numCastles; ++c) {
+            if (walk(c, tile) <= nearest + CONTEST_MARGIN) {
+                ++numNear;
+            }
+        }
+        if (numNear < 2) {
+            continue;
+        }
+        for (int c = 0; c < numCastles; ++c) {
+            if (walk(c, tile) == nearest) {
+                ++fairness.castles[c].contestedTiles;
+            }
+        }
+    }
+
+    auto &castles = fairness.castles;
+    fairness.score = spread(castles, [] (auto &c) { return c.villages; }) +
+        spread(castles, [] (auto &c) { return c.obelisks; }) +
+        spread(castles, [] (auto &c) { return c.chests; }) +
+        spread(castles, [] (auto &c) { return c.objectDistance; }) +
+        spread(castles, [] (auto &c) { return c.rivalDistance; }) +
+        spread(castles, [] (auto &c) { return c.contestedTiles; });
+    return fairness;
+}
+
+FairestMap fairest_map(int width,
+                       unsigned int seed,
+                       int numCandidates,
+                       const ObjectManager &objMgr,
+                       int numThreads)
+{
+    assert(numCandidates > 0);
+    std::vector<MapCandidate> candidates(numCandidates);
+    std::optional<RandomMap> bestMap;
+    int best = -1;
+    std::mutex bestMutex;
+
+    // Each candidate is generated on a single thread.  With many candidates,
+    // running whole maps side by side scales better than splitting up each one.
+    parallel_tasks(numCandidates, numThreads, [&] (int i) {
+        const auto candidateSeed = RandomRange::split_seed(seed, i);
+        RandomMap rmap(width, candidateSeed, objMgr);
+        const double score = map_fairness(rmap).score;
+
+        std::scoped_lock lock(bestMutex);
+        candidates[i] = {candidateSeed, score};
+        // Break ties by candidate number so the winner doesn't depend on which
+        // thread finished first.
+        if (best < 0 ||
+            std::tie(score, i) < std::tie(candidates[best].score, best))
+        {
+            best = i;
+            bestMap = std::move(rmap);
+        }
+    });
+
+    return {std::move(*bestMap), std::move(candidates), best};
+}
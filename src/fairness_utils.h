@@ -0,0 +1,78 @@
+/*
+    Copyright (C) 2025 by Michael Kristofik <kristo605@gmail.com>
+    Part of the Champions of Anduran project.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    or at your option any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY.
+
+    See the COPYING.txt file for more details.
+*/
+#ifndef FAIRNESS_UTILS_H
+#define FAIRNESS_UTILS_H
+
+#include "RandomMap.h"
+#include <vector>
+
+class ObjectManager;
+
+
+// What each player's starting castle has to work with, measured by walking
+// distance from the castle.
+struct CastleShare
+{
+    int tile = -1;
+
+    // Objects closer to this castle than to any other.  Ties are split evenly.
+    double villages = 0.0;
+    double obelisks = 0.0;
+    double chests = 0.0;
+
+    // Average distance to the nearest few of each of those object types.
+    double objectDistance = 0.0;
+
+    // Distance to the nearest rival castle, and the number of tiles this castle
+    // is closest to that are nearly as close to a rival.
+    int rivalDistance = 0;
+    int contestedTiles = 0;
+};
+
+struct MapFairness
+{
+    std::vector<CastleShare> castles;
+
+    // Sum of the relative spread (max - min over the mean) of each measure
+    // above.  Zero means every castle is equally well off, higher is more
+    // lopsided.
+    double score = 0.0;
+};
+
+MapFairness map_fairness(RandomMap &rmap);
+
+
+struct MapCandidate
+{
+    unsigned int seed = 0;
+    double score = 0.0;
+};
+
+struct FairestMap
+{
+    RandomMap map;
+    std::vector<MapCandidate> candidates;
+    int best = 0;  // index into candidates
+};
+
+// Generate several maps and keep the fairest one.  Candidate seeds are derived
+// from 'seed', so any of them can be generated again on its own.  Candidates
+// are generated in parallel, one map per thread.  The result doesn't depend on
+// the number of threads.
+FairestMap fairest_map(int width,
+                       unsigned int seed,
+                       int numCandidates,
+                       const ObjectManager &objMgr,
+                       int numThreads = 1);
+
+#endif
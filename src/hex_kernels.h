@@ -0,0 +1,53 @@
+/*
+    Copyright (C) 2025 by Michael Kristofik <kristo605@gmail.com>
+    Part of the Champions of Anduran project.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    or at your option any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY.
+
+    See the COPYING.txt file for more details.
+*/
+#ifndef HEX_KERNELS_H
+#define HEX_KERNELS_H
+
+#include "hex_utils.h"
+#include <span>
+
+// Internals of the batch distance functions in hex_utils.h.  Only hex_utils.cpp
+// and the unit tests should need these, so the tests can check every version
+// and not just the one this CPU would pick.
+
+// Everything the distance formula needs to know about the source hex.  See
+// hexDistance() for how the staggered columns work.  Note that x % 2 is
+// neither 0 nor 1 for negative odd columns.
+struct HexDistSource
+{
+    int x;
+    int y;
+    int even;  // x % 2 == 0
+    int odd;  // x % 2 == 1
+
+    explicit HexDistSource(const Hex &hex)
+        : x(hex.x),
+        y(hex.y),
+        even(hex.x % 2 == 0),
+        odd(hex.x % 2 == 1)
+    {
+    }
+};
+
+struct HexDistanceKernels
+{
+    const char *name;
+    void (*distances)(const HexDistSource &, const int *, const int *, int, int *);
+    void (*nearest)(const HexDistSource &, int, const int *, const int *, int, int *, int *);
+};
+
+// Every version this CPU can run, widest instructions first.  The functions in
+// hex_utils.h use the first one.
+std::span<const HexDistanceKernels> hexDistanceKernels();
+
+#endif
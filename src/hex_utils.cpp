@@ -11,10 +11,209 @@
     See the COPYING.txt file for more details.
 */
 #include "hex_utils.h"
+#include "hex_kernels.h"
+#include "thread_utils.h"
 
+#include <barrier>
+#include <cassert>
+#include <cstdlib>
 #include <limits>
 #include <sstream>
 #include <stdexcept>
+#include <utility>
+#include <vector>
+
+// The batch distance functions have x86 SIMD versions, chosen at runtime.
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HEX_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+namespace
+{
+    // How many random cluster layouts hexClusters() tries before picking one.
+    const int CLUSTER_ATTEMPTS = 100;
+
+    // Same as hexDistance(), without the branches.
+    int distance_scalar(const HexDistSource &src, int x, int y)
+    {
+        const int dx = std::abs(src.x - x);
+        const int dy = std::abs(src.y - y);
+        const int vPenalty = ((src.y < y) & src.even & (x % 2 == 1)) |
+            ((src.y > y) & src.odd & (x % 2 == 0));
+        return std::max(dx, dy + vPenalty + dx / 2);
+    }
+
+    void distances_scalar(const HexDistSource &src,
+                          const int *xs,
+                          const int *ys,
+                          int n,
+                          int *dist)
+    {
+        for (int i = 0; i < n; ++i) {
+            dist[i] = distance_scalar(src, xs[i], ys[i]);
+        }
+    }
+
+    void nearest_scalar(const HexDistSource &src,
+                        int srcIdx,
+                        const int *xs,
+                        const int *ys,
+                        int n,
+                        int *nearestDist,
+                        int *nearestIdx)
+    {
+        for (int i = 0; i < n; ++i) {
+            const int d = distance_scalar(src, xs[i], ys[i]);
+            if (d < nearestDist[i]) {
+                nearestDist[i] = d;
+                nearestIdx[i] = srcIdx;
+            }
+        }
+    }
+
+#ifdef HEX_X86_KERNELS
+    // Same formula, 8 hexes at a time.  Each step is one instruction per lane:
+    // parity comes from the low bit (and the sign, for odd columns), the
+    // comparisons produce all-ones masks, and dx / 2 is a shift because dx is
+    // never negative.
+    __attribute__((target("avx2")))
+    __m256i distance_avx2(const HexDistSource &src, __m256i x, __m256i y)
+    {
+        const __m256i one = _mm256_set1_epi32(1);
+        const __m256i srcY = _mm256_set1_epi32(src.y);
+        const __m256i dx = _mm256_abs_epi32(_mm256_sub_epi32(x, _mm256_set1_epi32(src.x)));
+        const __m256i dy = _mm256_abs_epi32(_mm256_sub_epi32(y, srcY));
+
+        const __m256i lowBit = _mm256_and_si256(x, one);
+        const __m256i odd = _mm256_and_si256(lowBit,
+            _mm256_cmpgt_epi32(x, _mm256_setzero_si256()));
+        const __m256i even = _mm256_xor_si256(lowBit, one);
+        const __m256i below = _mm256_cmpgt_epi32(y, srcY);
+        const __m256i above = _mm256_cmpgt_epi32(srcY, y);
+        const __m256i vPenalty = _mm256_or_si256(
+            _mm256_and_si256(below, _mm256_and_si256(odd, _mm256_set1_epi32(src.even))),
+            _mm256_and_si256(above, _mm256_and_si256(even, _mm256_set1_epi32(src.odd))));
+
+        const __m256i steps = _mm256_add_epi32(_mm256_add_epi32(dy, vPenalty),
+                                               _mm256_srli_epi32(dx, 1));
+        return _mm256_max_epi32(dx, steps);
+    }
+
+    __attribute__((target("avx2")))
+    void distances_avx2(const HexDistSource &src,
+                        const int *xs,
+                        const int *ys,
+                        int n,
+                        int *dist)
+    {
+        int i = 0;
+        for (; i + 8 <= n; i += 8) {
+            const auto x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(xs + i));
+            const auto y = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(ys + i));
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(dist + i),
+                                distance_avx2(src, x, y));
+        }
+        distances_scalar(src, xs + i, ys + i, n - i, dist + i);
+    }
+
+    __attribute__((target("avx2")))
+    void nearest_avx2(const HexDistSource &src,
+                      int srcIdx,
+                      const int *xs,
+                      const int *ys,
+                      int n,
+                      int *nearestDist,
+                      int *nearestIdx)
+    {
+        const __m256i idx = _mm256_set1_epi32(srcIdx);
+        int i = 0;
+        for (; i + 8 <= n; i += 8) {
+            const auto x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(xs + i));
+            const auto y = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(ys + i));
+            auto *distPtr = reinterpret_cast<__m256i *>(nearestDist + i);
+            auto *idxPtr = reinterpret_cast<__m256i *>(nearestIdx + i);
+
+            const __m256i d = distance_avx2(src, x, y);
+            const __m256i oldDist = _mm256_loadu_si256(distPtr);
+            const __m256i closer = _mm256_cmpgt_epi32(oldDist, d);
+            _mm256_storeu_si256(distPtr, _mm256_min_epi32(oldDist, d));
+            _mm256_storeu_si256(idxPtr,
+                _mm256_blendv_epi8(_mm256_loadu_si256(idxPtr), idx, closer));
+        }
+        nearest_scalar(src, srcIdx, xs + i, ys + i, n - i,
+                       nearestDist + i, nearestIdx + i);
+    }
+
+    // Same as the AVX2 versions, 4 hexes at a time.
+    __attribute__((target("sse4.1")))
+    __m128i distance_sse41(const HexDistSource &src, __m128i x, __m128i y)
+    {
+        const __m128i one = _mm_set1_epi32(1);
+        const __m128i srcY = _mm_set1_epi32(src.y);
+        const __m128i dx = _mm_abs_epi32(_mm_sub_epi32(x, _mm_set1_epi32(src.x)));
+        const __m128i dy = _mm_abs_epi32(_mm_sub_epi32(y, srcY));
+
+        const __m128i lowBit = _mm_and_si128(x, one);
+        const __m128i odd = _mm_and_si128(lowBit, _mm_cmpgt_epi32(x, _mm_setzero_si128()));
+        const __m128i even = _mm_xor_si128(lowBit, one);
+        const __m128i below = _mm_cmpgt_epi32(y, srcY);
+        const __m128i above = _mm_cmpgt_epi32(srcY, y);
+        const __m128i vPenalty = _mm_or_si128(
+            _mm_and_si128(below, _mm_and_si128(odd, _mm_set1_epi32(src.even))),
+            _mm_and_si128(above, _mm_and_si128(even, _mm_set1_epi32(src.odd))));
+
+        const __m128i steps = _mm_add_epi32(_mm_add_epi32(dy, vPenalty),
+                                            _mm_srli_epi32(dx, 1));
+        return _mm_max_epi32(dx, steps);
+    }
+
+    __attribute__((target("sse4.1")))
+    void distances_sse41(const HexDistSource &src,
+                         const int *xs,
+                         const int *ys,
+                         int n,
+                         int *dist)
+    {
+        int i = 0;
+        for (; i + 4 <= n; i += 4) {
+            const auto x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(xs + i));
+            const auto y = _mm_loadu_si128(reinterpret_cast<const __m128i *>(ys + i));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dist + i),
+                             distance_sse41(src, x, y));
+        }
+        distances_scalar(src, xs + i, ys + i, n - i, dist + i);
+    }
+
+    __attribute__((target("sse4.1")))
+    void nearest_sse41(const HexDistSource &src,
+                       int srcIdx,
+                       const int *xs,
+                       const int *ys,
+                       int n,
+                       int *nearestDist,
+                       int *nearestIdx)
+    {
+        const __m128i idx = _mm_set1_epi32(srcIdx);
+        int i = 0;
+        for (; i + 4 <= n; i += 4) {
+            const auto x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(xs + i));
+            const auto y = _mm_loadu_si128(reinterpret_cast<const __m128i *>(ys + i));
+            auto *distPtr = reinterpret_cast<__m128i *>(nearestDist + i);
+            auto *idxPtr = reinterpret_cast<__m128i *>(nearestIdx + i);
+
+            const __m128i d = distance_sse41(src, x, y);
+            const __m128i oldDist = _mm_loadu_si128(distPtr);
+            const __m128i closer = _mm_cmpgt_epi32(oldDist, d);
+            _mm_storeu_si128(distPtr, _mm_min_epi32(oldDist, d));
+            _mm_storeu_si128(idxPtr, _mm_blendv_epi8(_mm_loadu_si128(idxPtr), idx, closer));
+        }
+        nearest_scalar(src, srcIdx, xs + i, ys + i, n - i,
+                       nearestDist + i, nearestIdx + i);
+    }
+#endif
+}
+
 
 Hex::Hex()
     : x(std::numeric_limits<int>::min()),
@@ -187,22 +386,315 @@ int hexClosestIdx(const Hex &hSrc, const std::vector<Hex> &hexes)
     return static_cast<int>(distance(begin(hexes), closest));
 }
 
-std::vector<Hex> hexCircle(const Hex &center, int radius)
+void hexDistances(const Hex &src,
+                  std::span<const int> xs,
+                  std::span<const int> ys,
+                  std::span<int> dist)
 {
-    std::vector<Hex> hexes;
+    assert(src && xs.size() == ys.size() && dist.size() >= xs.size());
+    hexDistanceKernels().front().distances(HexDistSource(src), xs.data(), ys.data(), ssize(xs),
+                                 dist.data());
+}
+
+void hexUpdateNearest(const Hex &center,
+                      int centerIdx,
+                      std::span<const int> xs,
+                      std::span<const int> ys,
+                      std::span<int> nearestDist,
+                      std::span<int> nearestIdx)
+{
+    assert(center && xs.size() == ys.size());
+    assert(nearestDist.size() >= xs.size() && nearestIdx.size() >= xs.size());
+    hexDistanceKernels().front().nearest(HexDistSource(center), centerIdx,
+                                         xs.data(), ys.data(), ssize(xs),
+                                         nearestDist.data(), nearestIdx.data());
+}
+
+std::vector<int> hexClosestIdx(const HexArray &hexes, const std::vector<Hex> &centers)
+{
+    std::vector<int> nearestDist(hexes.size(), std::numeric_limits<int>::max());
+    std::vector<int> nearestIdx(hexes.size(), -1);
+    for (int c = 0; c < ssize(centers); ++c) {
+        hexUpdateNearest(centers[c], c, hexes, nearestDist, nearestIdx);
+    }
+    return nearestIdx;
+}
 
+const char * hexDistanceKernel()
+{
+    return hexDistanceKernels().front().name;
+}
+
+std::span<const HexDistanceKernels> hexDistanceKernels()
+{
+    // Checking the CPU isn't free, do it once.
+    static const std::vector<HexDistanceKernels> kernels = [] {
+        std::vector<HexDistanceKernels> supported;
+#ifdef HEX_X86_KERNELS
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) {
+            supported.push_back({"avx2", distances_avx2, nearest_avx2});
+        }
+        if (__builtin_cpu_supports("sse4.1")) {
+            supported.push_back({"sse4.1", distances_sse41, nearest_sse41});
+        }
+#endif
+        supported.push_back({"scalar", distances_scalar, nearest_scalar});
+        return supported;
+    }();
+    return kernels;
+}
+
+std::vector<int> hexClosestIdxGrid(int width, const std::vector<Hex> &centers)
+{
+    const int size = width * width;
+    std::vector<int> closest(size, -1);
+    std::vector<int> dist(size, -1);
+    std::vector<int> frontier;
+    std::vector<int> next;
+
+    auto offGrid = [width] (const Hex &hex) {
+        return hex.x < 0 || hex.y < 0 || hex.x >= width || hex.y >= width;
+    };
+
+    // Seed the search with every center.  If two centers land on the same hex,
+    // the lower index wins, same as hexClosestIdx().
+    for (int c = 0; c < ssize(centers); ++c) {
+        assert(!offGrid(centers[c]));
+        const int index = centers[c].y * width + centers[c].x;
+        if (closest[index] < 0) {
+            closest[index] = c;
+            dist[index] = 0;
+            frontier.push_back(index);
+        }
+    }
+
+    // Breadth-first search outward from all centers at once, one distance step
+    // at a time.  Shortest paths on the grid never need to leave it, so the
+    // step count matches hexDistance().  Every center that's closest to a hex
+    // is also closest to one of the hexes one step before it, so taking the
+    // lowest index from among those reproduces the tie-breaking rule.
+    for (int d = 1; !frontier.empty(); ++d) {
+        next.clear();
+        for (int index : frontier) {
+            const Hex hex(index % width, index / width);
+            for (auto &hNbr : hex.getAllNeighbors()) {
+                if (offGrid(hNbr)) {
+                    continue;
+                }
+
+                const int iNbr = hNbr.y * width + hNbr.x;
+                if (dist[iNbr] < 0) {
+                    dist[iNbr] = d;
+                    closest[iNbr] = closest[index];
+                    next.push_back(iNbr);
+                }
+                else if (dist[iNbr] == d) {
+                    closest[iNbr] = std::min(closest[iNbr], closest[index]);
+                }
+            }
+        }
+        frontier.swap(next);
+    }
+
+    return closest;
+}
+
+std::vector<int> hexClosestIdxGrid(int width,
+                                   const std::vector<Hex> &centers,
+                                   int numThreads)
+{
+    if (numThreads <= 1 || centers.empty() || width < numThreads) {
+        return hexClosestIdxGrid(width, centers);
+    }
+
+    const int size = width * width;
+    std::vector<int> closest(size, -1);
+    std::vector<int> dist(size, -1);
+
+    // Each thread owns a band of rows.  It's the only one allowed to write to
+    // the tiles in its band, and to the frontier of tiles in its band.
+    using Proposal = std::pair<int, int>;  // tile index, center index
+    std::vector<std::vector<int>> frontiers(numThreads);
+    std::vector<int> frontierSizes(numThreads, 0);
+    std::vector<int> bandBegin(numThreads + 1, size);
+    std::vector<std::vector<std::vector<Proposal>>> outbox(
+        numThreads, std::vector<std::vector<Proposal>>(numThreads));
+
+    auto bandOf = [&bandBegin] (int index) {
+        auto iter = std::ranges::upper_bound(bandBegin, index);
+        return static_cast<int>(distance(begin(bandBegin), iter)) - 1;
+    };
+    auto offGrid = [width] (const Hex &hex) {
+        return hex.x < 0 || hex.y < 0 || hex.x >= width || hex.y >= width;
+    };
+
+    for (int b = 0; b < numThreads; ++b) {
+        bandBegin[b] = width * (width * b / numThreads);
+    }
+    for (int c = 0; c < ssize(centers); ++c) {
+        assert(!offGrid(centers[c]));
+        const int index = centers[c].y * width + centers[c].x;
+        if (closest[index] < 0) {
+            closest[index] = c;
+            dist[index] = 0;
+            frontiers[bandOf(index)].push_back(index);
+        }
+    }
+
+    // Same breadth-first search as the serial version, done in two phases per
+    // step, with every thread waiting for the others between phases:
+    // 1. Read-only: each thread proposes its frontier's center to every
+    //    unassigned neighbor, sorted by which band the neighbor lives in.
+    // 2. Each thread applies the proposals for tiles in its own band, lowest
+    //    center index wins.  Those tiles become the next frontier.
+    std::barrier sync(numThreads);
+    parallel_blocks(numThreads, numThreads, [&] (int, int, int band) {
+        for (int d = 1; ; ++d) {
+            for (auto &box : outbox[band]) {
+                box.clear();
+            }
+            for (int index : frontiers[band]) {
+                const Hex hex(index % width, index / width);
+                for (auto &hNbr : hex.getAllNeighbors()) {
+                    if (offGrid(hNbr)) {
+                        continue;
+                    }
+                    const int iNbr = hNbr.y * width + hNbr.x;
+                    if (dist[iNbr] < 0) {
+                        outbox[band][bandOf(iNbr)].emplace_back(iNbr, closest[index]);
+                    }
+                }
+            }
+            sync.arrive_and_wait();
+
+            auto &frontier = frontiers[band];
+            frontier.clear();
+            for (int src = 0; src < numThreads; ++src) {
+                for (auto [index, center] : outbox[src][band]) {
+                    if (dist[index] < 0) {
+                        dist[index] = d;
+                        closest[index] = center;
+                        frontier.push_back(index);
+                    }
+                    else {
+                        closest[index] = std::min(closest[index], center);
+                    }
+                }
+            }
+            frontierSizes[band] = ssize(frontier);
+            sync.arrive_and_wait();
+
+            if (std::ranges::all_of(frontierSizes, [] (int sz) { return sz == 0; })) {
+                break;
+            }
+        }
+    });
+
+    return closest;
+}
+
+std::vector<Hex> hexCircle(const Hex &center, int radius)
+{
+    // Measure every hex in the bounding box at once, keep the ones in range.
+    HexArray box;
     for (auto x = center.x - radius; x <= center.x + radius; ++x) {
         for (auto y = center.y - radius; y <= center.y + radius; ++y) {
-            const Hex h{x, y};
-            if (hexDistance(h, center) <= radius) {
-                hexes.push_back(h);
-            }
+            box.x.push_back(x);
+            box.y.push_back(y);
+        }
+    }
+    std::vector<int> dist(box.size());
+    hexDistances(center, box, dist);
+
+    std::vector<Hex> hexes;
+    for (int i = 0; i < box.size(); ++i) {
+        if (dist[i] <= radius) {
+            hexes.push_back(box[i]);
         }
     }
 
     return hexes;
 }
 
+// Other algorithms considered:
+// - https://en.wikipedia.org/wiki/K-means%2B%2B
+// - several naive attempts that performed worse, some comically bad
+std::vector<int> hexClusters(const HexArray &hexes, int numClusters, int numThreads)
+{
+    const int numHexes = hexes.size();
+    if (numHexes == 0 || numClusters <= 0) {
+        return {};
+    }
+    const double expectedSize = numHexes / static_cast<double>(numClusters);
+
+    // Dividing the hexes equally into contiguous groups is NP-hard
+    // (https://en.wikipedia.org/wiki/K-means_clustering).  The method
+    // RandomMap.cpp uses to produce a Voronoi diagram doesn't consistently yield
+    // clusters of similar size.  So we'll cheat.  We will produce 100 of
+    // them and pick the best one.
+    //
+    // Each attempt gets its own random number stream, and ties go to the
+    // lowest numbered attempt, so the result doesn't depend on which thread
+    // ran what.
+    const unsigned int seed = RandomRange::engine();
+
+    struct Attempt
+    {
+        double variance = std::numeric_limits<double>::infinity();
+        std::vector<int> clusters;
+    };
+
+    std::vector<Attempt> blockBest(std::clamp(numThreads, 1, CLUSTER_ATTEMPTS));
+    parallel_blocks(CLUSTER_ATTEMPTS, numThreads, [&] (int begin, int end, int block) {
+        std::vector<int> nearestDist(numHexes);
+        std::vector<int> clusters(numHexes);
+        std::vector<int> clusterSizes(numClusters);
+
+        for (int a = begin; a < end; ++a) {
+            ScopedRandomSeed scopedSeed(RandomRange::split_seed(seed, a));
+            RandomRange randElem(0, numHexes - 1);
+
+            // Randomly choose the initial centers of each cluster.  Pick one
+            // hex, and then for each one after that, choose the hex farthest
+            // from its nearest existing center.  Keeping track of every hex's
+            // nearest center as we go also assigns each hex to its cluster.
+            // source: https://en.wikipedia.org/wiki/Farthest-first_traversal
+            std::ranges::fill(nearestDist, std::numeric_limits<int>::max());
+            int next = randElem.get();
+            for (int c = 0; c < numClusters; ++c) {
+                hexUpdateNearest(hexes[next], c, hexes, nearestDist, clusters);
+                next = std::ranges::max_element(nearestDist) - std::begin(nearestDist);
+            }
+
+            // Traditionally, we'd run Lloyd's Algorithm here until it converges
+            // (https://en.wikipedia.org/wiki/Lloyd%27s_algorithm).  But testing
+            // showed that often made the clusters less consistent in size.
+            // Cheating again, we will test whether the initial setup was good
+            // enough.  After 100 attempts, several of them usually are.
+            std::ranges::fill(clusterSizes, 0);
+            for (int c : clusters) {
+                ++clusterSizes[c];
+            }
+            const double var = range_variance(clusterSizes, expectedSize);
+            if (var < blockBest[block].variance) {
+                blockBest[block] = {var, clusters};
+            }
+        }
+    });
+
+    // Blocks cover the attempts in order, so taking the first of equals keeps
+    // the lowest numbered attempt.
+    Attempt best;
+    for (auto &attempt : blockBest) {
+        if (attempt.variance < best.variance) {
+            best = std::move(attempt);
+        }
+    }
+
+    return best.clusters;
+}
+
 HexDir oppositeHexDir(HexDir d)
 {
     int sz = enum_size<HexDir>();
@@ -67,6 +67,22 @@ struct Hex
 using Path = std::vector<Hex>;
 using PathView = std::span<Hex>;
 
+
+// A list of hexes stored as separate arrays of x and y coordinates (structure
+// of arrays), so distances to many hexes can be computed several at a time.
+struct HexArray
+{
+    std::vector<int> x;
+    std::vector<int> y;
+
+    HexArray() = default;
+    template <typename R>
+    explicit HexArray(const R &hexes);
+
+    int size() const;
+    Hex operator[](int i) const;
+};
+
 Hex operator+(Hex lhs, const Hex &rhs);
 Hex operator-(Hex lhs, const Hex &rhs);
 Hex operator/(const Hex &lhs, int rhs);
@@ -78,6 +94,49 @@ int hexDistance(const Hex &h1, const Hex &h2);
 // Given a list of hexes, return the index of the hex closest to the source.
 int hexClosestIdx(const Hex &hSrc, const std::vector<Hex> &hexes);
 
+// Batch versions of the above for hexes stored as separate x and y arrays.
+// Every hex must be valid.  These run 8 or 4 hexes at a time using AVX2 or
+// SSE4.1 instructions if the CPU has them, or one at a time if not.
+//
+// Distance from 'src' to each hex.
+void hexDistances(const Hex &src,
+                  std::span<const int> xs,
+                  std::span<const int> ys,
+                  std::span<int> dist);
+void hexDistances(const Hex &src, const HexArray &hexes, std::span<int> dist);
+
+// For each hex, lower nearestDist to its distance from 'center', and set
+// nearestIdx to 'centerIdx' where that's strictly closer.  Calling this for
+// each center in order gives the same answer as hexClosestIdx().
+void hexUpdateNearest(const Hex &center,
+                      int centerIdx,
+                      std::span<const int> xs,
+                      std::span<const int> ys,
+                      std::span<int> nearestDist,
+                      std::span<int> nearestIdx);
+void hexUpdateNearest(const Hex &center,
+                      int centerIdx,
+                      const HexArray &hexes,
+                      std::span<int> nearestDist,
+                      std::span<int> nearestIdx);
+
+// Same as calling hexClosestIdx() for each hex.
+std::vector<int> hexClosestIdx(const HexArray &hexes, const std::vector<Hex> &centers);
+
+// Which version of the batch functions this CPU uses ("avx2", "sse4.1", or
+// "scalar").
+const char * hexDistanceKernel();
+
+// Same as calling hexClosestIdx() for every hex on a square map of the given
+// width (ties go to the lowest index), but in linear time no matter how many
+// centers there are.  Result is indexed by y * width + x.
+std::vector<int> hexClosestIdxGrid(int width, const std::vector<Hex> &centers);
+
+// Same result as above, with the rows of the map split across threads.
+std::vector<int> hexClosestIdxGrid(int width,
+                                   const std::vector<Hex> &centers,
+                                   int numThreads);
+
 // Set of all hexes within 'radius' distance of the center.
 std::vector<Hex> hexCircle(const Hex &center, int radius);
 
@@ -86,9 +145,31 @@ std::vector<Hex> hexCircle(const Hex &center, int radius);
 HexDir oppositeHexDir(HexDir d);
 
 // Divide a set of hexes into N similarly sized clusters, assigning each hex a
-// cluster number 0 to N-1.
+// cluster number 0 to N-1.  The work is split across threads, but the result
+// only depends on the state of the calling thread's random number engine.
+std::vector<int> hexClusters(const HexArray &hexes, int numClusters, int numThreads = 1);
+
 template <typename R>
-std::vector<int> hexClusters(const R &hexes, int numClusters);
+std::vector<int> hexClusters(const R &hexes, int numClusters, int numThreads = 1);
+
+
+// Tiles adjacent to a tile index on a square map of the given width, computed
+// directly from the index.  Tiles off the edge of the map are skipped.
+// Neighbors come out in increasing index order.
+class TileNeighbors
+{
+public:
+    TileNeighbors(int index, int width);
+
+    const int * begin() const { return tiles_.data(); }
+    const int * end() const { return tiles_.data() + size_; }
+    int size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+private:
+    std::array<int, 6> tiles_;
+    int size_;
+};
 
 
 // Use Concepts to fake a non-templated parameter pack.
@@ -100,68 +181,71 @@ Hex Hex::getNeighbor(HexDir d, std::same_as<HexDir> auto... dirs) const
 }
 
 
-// Other algorithms considered:
-// - https://en.wikipedia.org/wiki/K-means%2B%2B
-// - several naive attempts that performed worse, some comically bad
-template <typename R>
-std::vector<int> hexClusters(const R &hexes, int numClusters)
+inline TileNeighbors::TileNeighbors(int index, int width)
+    : tiles_(),
+    size_(0)
 {
-    std::vector<int> bestClusters;
-    auto expectedSize = ssize(hexes) / static_cast<double>(numClusters);
-    double bestVariance = 10.0;  // don't consider anything worse than this
-
-    // Dividing the hexes equally into contiguous groups is NP-hard
-    // (https://en.wikipedia.org/wiki/K-means_clustering).  The method
-    // RandomMap.cpp uses to produce a Voronoi diagram doesn't consistently yield
-    // clusters of similar size.  So we'll cheat.  We will produce 100 of
-    // them and pick the best one.
-
-    std::vector<Hex> centers;  // center of mass for each cluster
-    std::vector<int> clusters(size(hexes));
-    std::vector<int> clusterSizes(numClusters, 0);
-    RandomRange randElem(0, ssize(hexes) - 1);
-
-    int i = 0;
-    while (i < 100 || bestClusters.empty()) {
-        // Randomly choose the initial centers of each cluster.  Pick one hex, and
-        // then for each one after that, choose the hex farthest from its nearest
-        // existing center.
-        // source: https://en.wikipedia.org/wiki/Farthest-first_traversal
-        centers.clear();
-        centers.push_back(hexes[randElem.get()]);
-        for (int j = 1; j < numClusters; ++j) {
-            auto distNearest = [&centers] (const Hex &hex) {
-                int nearest = hexClosestIdx(hex, centers);
-                return hexDistance(hex, centers[nearest]);
-            };
-            auto iter = std::ranges::max_element(hexes, {}, distNearest);
-            centers.push_back(*iter);
-        }
-
-        // Assign each hex to its nearest center.
-        std::ranges::fill(clusters, 0);
-        std::ranges::fill(clusterSizes, 0);
-        for (int h = 0; h < ssize(hexes); ++h) {
-            int c = hexClosestIdx(hexes[h], centers);
-            clusters[h] = c;
-            ++clusterSizes[c];
+    // Offsets as {x, y}, sorted so the tile indexes are increasing.  See
+    // Hex::getNeighbor().
+    static constexpr int evenCol[6][2] = {
+        {-1, -1}, {0, -1}, {1, -1}, {-1, 0}, {1, 0}, {0, 1}
+    };
+    static constexpr int oddCol[6][2] = {
+        {0, -1}, {-1, 0}, {1, 0}, {-1, 1}, {0, 1}, {1, 1}
+    };
+
+    const int x = index % width;
+    const int y = index / width;
+    const auto &offsets = (x % 2 == 0) ? evenCol : oddCol;
+    for (const auto &[dx, dy] : offsets) {
+        if (x + dx >= 0 && x + dx < width && y + dy >= 0 && y + dy < width) {
+            tiles_[size_++] = index + dy * width + dx;
         }
+    }
+}
 
-        // Traditionally, we'd run Lloyd's Algorithm here until it converges
-        // (https://en.wikipedia.org/wiki/Lloyd%27s_algorithm).  But testing
-        // showed that often made the clusters less consistent in size.  Cheating
-        // again, we will test whether the initial setup was good enough.  After
-        // 100 iterations, several of them usually are.
-        double var = range_variance(clusterSizes, expectedSize);
-        if (var < bestVariance) {
-            bestClusters = clusters;
-            bestVariance = var;
-        }
 
-        ++i;
+template <typename R>
+HexArray::HexArray(const R &hexes)
+    : x(),
+    y()
+{
+    for (const Hex &hex : hexes) {
+        x.push_back(hex.x);
+        y.push_back(hex.y);
     }
+}
+
+inline int HexArray::size() const
+{
+    return std::ssize(x);
+}
+
+inline Hex HexArray::operator[](int i) const
+{
+    return {x[i], y[i]};
+}
+
 
-    return bestClusters;
+inline void hexDistances(const Hex &src, const HexArray &hexes, std::span<int> dist)
+{
+    hexDistances(src, hexes.x, hexes.y, dist);
+}
+
+inline void hexUpdateNearest(const Hex &center,
+                             int centerIdx,
+                             const HexArray &hexes,
+                             std::span<int> nearestDist,
+                             std::span<int> nearestIdx)
+{
+    hexUpdateNearest(center, centerIdx, hexes.x, hexes.y, nearestDist, nearestIdx);
+}
+
+
+template <typename R>
+std::vector<int> hexClusters(const R &hexes, int numClusters, int numThreads)
+{
+    return hexClusters(HexArray(hexes), numClusters, numThreads);
 }
 
 #endif
@@ -1,5 +1,5 @@
 /*
-    Copyright (C) 2016-2019 by Michael Kristofik <kristo605@gmail.com>
+    Copyright (C) 2016-2025 by Michael Kristofik <kristo605@gmail.com>
     Part of the Champions of Anduran project.
  
     This program is free software; you can redistribute it and/or modify
@@ -16,11 +16,16 @@
 #include "rapidjson/filereadstream.h"
 #include "rapidjson/filewritestream.h"
 #include "rapidjson/prettywriter.h"
+#include "rapidjson/reader.h"
+#include "rapidjson/writer.h"
 
+#include <algorithm>
 #include <cstdio>
 #include <format>
 #include <memory>
 #include <stdexcept>
+#include <string_view>
+#include <utility>
 
 namespace
 {
@@ -33,7 +38,7 @@ rapidjson::Document jsonReadFile(const char *filename)
     rapidjson::Document doc;
 
     char buf[JSON_BUFFER_SIZE];
-    std::shared_ptr<FILE> jsonFile(fopen(filename, "rb"), fclose);
+    std::unique_ptr<FILE, decltype(&fclose)> jsonFile(fopen(filename, "rb"), fclose);
     if (!jsonFile) {
         auto msg = std::format("json file not found: {}", filename);
         log_error(msg);
@@ -46,15 +51,270 @@ rapidjson::Document jsonReadFile(const char *filename)
     return doc;
 }
 
-void jsonWriteFile(const char *filename, const rapidjson::Document &doc)
+void jsonWriteFile(const char *filename,
+                   const rapidjson::Document &doc,
+                   JsonFormat format)
+{
+    std::unique_ptr<FILE, decltype(&fclose)> jsonFile(fopen(filename, "wb"), fclose);
+    if (!jsonFile) {
+        auto msg = std::format("couldn't open json file for writing: {}", filename);
+        log_error(msg);
+        throw std::runtime_error(msg);
+    }
+
+    jsonWriteFile(jsonFile.get(), doc, format);
+}
+
+void jsonWriteFile(FILE *file, const rapidjson::Document &doc, JsonFormat format)
 {
     using namespace rapidjson;
 
     char buf[JSON_BUFFER_SIZE];
-    std::shared_ptr<FILE> jsonFile(fopen(filename, "wb"), fclose);
-    FileWriteStream ostr(jsonFile.get(), buf, sizeof(buf));
-    PrettyWriter<FileWriteStream> writer(ostr);
+    FileWriteStream ostr(file, buf, sizeof(buf));
+    if (format == JsonFormat::compact) {
+        Writer<FileWriteStream> writer(ostr);
+        doc.Accept(writer);
+    }
+    else {
+        PrettyWriter<FileWriteStream> writer(ostr);
+        writer.SetFormatOptions(kFormatSingleLineArray);
+        doc.Accept(writer);
+    }
+}
+
+
+// SAX handler for JsonArrayReader.  Tracks how deeply nested we are so that
+// only the registered top-level arrays (and the arrays inside registered
+// multimap objects) are captured.
+class JsonArrayReader::Handler
+    : public rapidjson::BaseReaderHandler<rapidjson::UTF8<>, Handler>
+{
+public:
+    explicit Handler(JsonArrayReader &reader)
+        : reader_(&reader),
+        depth_(0),
+        nextArray_(nullptr),
+        curArray_(nullptr),
+        nextMultimap_(nullptr),
+        curMultimap_(nullptr),
+        multimapKey_(),
+        inMultimapArray_(false)
+    {
+    }
+
+    bool Default() { return !capturing(); }  // arrays must hold only integers
+
+    bool Int(int i) { return push(i); }
+    bool Uint(unsigned u) { return push(static_cast<int>(u)); }
+
+    bool Key(const char *str, rapidjson::SizeType length, bool)
+    {
+        std::string_view key(str, length);
+        if (depth_ == 1) {
+            nextArray_ = findArray(key);
+            nextMultimap_ = findMultimap(key);
+        }
+        else if (depth_ == 2 && curMultimap_) {
+            multimapKey_ = key;
+        }
+        return true;
+    }
+
+    bool StartObject()
+    {
+        if (capturing()) {
+            return false;
+        }
+        if (depth_ == 1) {
+            curMultimap_ = std::exchange(nextMultimap_, nullptr);
+            nextArray_ = nullptr;
+        }
+        ++depth_;
+        return true;
+    }
+
+    bool EndObject(rapidjson::SizeType)
+    {
+        --depth_;
+        if (depth_ == 1) {
+            curMultimap_ = nullptr;
+        }
+        return true;
+    }
+
+    bool StartArray()
+    {
+        if (capturing()) {
+            return false;  // nested arrays aren't supported
+        }
+        if (depth_ == 1) {
+            curArray_ = std::exchange(nextArray_, nullptr);
+            nextMultimap_ = nullptr;
+            if (curArray_) {
+                curArray_->start();
+            }
+        }
+        else if (depth_ == 2 && curMultimap_) {
+            inMultimapArray_ = true;
+        }
+        ++depth_;
+        return true;
+    }
+
+    bool EndArray(rapidjson::SizeType)
+    {
+        --depth_;
+        curArray_ = nullptr;
+        inMultimapArray_ = false;
+        return true;
+    }
+
+private:
+    bool capturing() const { return curArray_ || inMultimapArray_; }
+
+    bool push(int value)
+    {
+        if (curArray_) {
+            curArray_->push(value);
+        }
+        else if (inMultimapArray_) {
+            curMultimap_->insert(multimapKey_, value);
+        }
+        return true;
+    }
+
+    Sink * findArray(std::string_view key) const
+    {
+        auto iter = std::ranges::find(reader_->arrays_, key,
+                                      [] (const auto &elem) { return elem.first; });
+        return iter != std::end(reader_->arrays_) ? iter->second.get() : nullptr;
+    }
+
+    FlatMultimap<std::string, int> * findMultimap(std::string_view key) const
+    {
+        auto iter = std::ranges::find(reader_->multimaps_, key,
+                                      [] (const auto &elem) { return elem.first; });
+        return iter != std::end(reader_->multimaps_) ? iter->second : nullptr;
+    }
+
+    JsonArrayReader *reader_;
+    int depth_;
+    Sink *nextArray_;  // array for the key we just saw
+    Sink *curArray_;
+    FlatMultimap<std::string, int> *nextMultimap_;
+    FlatMultimap<std::string, int> *curMultimap_;
+    std::string multimapKey_;
+    bool inMultimapArray_;
+};
+
+
+JsonArrayReader::JsonArrayReader()
+    : arrays_(),
+    multimaps_()
+{
+}
+
+JsonArrayReader::~JsonArrayReader() = default;
+
+void JsonArrayReader::addMultimap(const char *name,
+                                  FlatMultimap<std::string, int> &outMap)
+{
+    multimaps_.emplace_back(name, &outMap);
+}
+
+void JsonArrayReader::read(const char *filename)
+{
+    char buf[JSON_BUFFER_SIZE];
+    std::unique_ptr<FILE, decltype(&fclose)> jsonFile(fopen(filename, "rb"), fclose);
+    if (!jsonFile) {
+        auto msg = std::format("json file not found: {}", filename);
+        log_error(msg);
+        throw std::runtime_error(msg);
+    }
+
+    rapidjson::FileReadStream istr(jsonFile.get(), buf, sizeof(buf));
+    rapidjson::Reader reader;
+    Handler handler(*this);
+    reader.Parse(istr, handler);
+    if (reader.HasParseError()) {
+        auto msg = std::format("couldn't parse json file {} at offset {}",
+                               filename, reader.GetErrorOffset());
+        log_error(msg);
+        throw std::runtime_error(msg);
+    }
+}
 
-    writer.SetFormatOptions(kFormatSingleLineArray);
-    doc.Accept(writer);
+
+class JsonArrayWriter::Impl
+{
+public:
+    explicit Impl(const char *filename)
+        : filename_(filename),
+        file_(fopen(filename, "wb"), fclose),
+        buf_(),
+        ostr_(nullptr),
+        writer_()
+    {
+        if (!file_) {
+            auto msg = std::format("couldn't open json file for writing: {}", filename);
+            log_error(msg);
+            throw std::runtime_error(msg);
+        }
+        ostr_ = std::make_unique<rapidjson::FileWriteStream>(file_.get(), buf_,
+                                                             sizeof(buf_));
+        writer_.Reset(*ostr_);
+    }
+
+    std::string filename_;
+    std::unique_ptr<FILE, decltype(&fclose)> file_;
+    char buf_[JSON_BUFFER_SIZE];
+    std::unique_ptr<rapidjson::FileWriteStream> ostr_;
+    rapidjson::Writer<rapidjson::FileWriteStream> writer_;
+};
+
+
+JsonArrayWriter::JsonArrayWriter(const char *filename)
+    : impl_(std::make_unique<Impl>(filename))
+{
+    impl_->writer_.StartObject();
+}
+
+JsonArrayWriter::~JsonArrayWriter() = default;
+
+void JsonArrayWriter::startArray(const char *name)
+{
+    impl_->writer_.Key(name);
+    impl_->writer_.StartArray();
+}
+
+void JsonArrayWriter::push(int value)
+{
+    impl_->writer_.Int(value);
+}
+
+void JsonArrayWriter::endArray()
+{
+    impl_->writer_.EndArray();
+}
+
+void JsonArrayWriter::startObject(const char *name)
+{
+    impl_->writer_.Key(name);
+    impl_->writer_.StartObject();
+}
+
+void JsonArrayWriter::endObject()
+{
+    impl_->writer_.EndObject();
+}
+
+void JsonArrayWriter::finish()
+{
+    impl_->writer_.EndObject();
+    impl_->ostr_->Flush();
+    if (!impl_->writer_.IsComplete() || fflush(impl_->file_.get()) != 0) {
+        auto msg = std::format("couldn't write json file: {}", impl_->filename_);
+        log_error(msg);
+        throw std::runtime_error(msg);
+    }
 }
@@ -1,5 +1,5 @@
 /*
-    Copyright (C) 2016-2022 by Michael Kristofik <kristo605@gmail.com>
+    Copyright (C) 2016-2025 by Michael Kristofik <kristo605@gmail.com>
     Part of the Champions of Anduran project.
  
     This program is free software; you can redistribute it and/or modify
@@ -17,8 +17,12 @@
 #include "rapidjson/document.h"
 
 #include <concepts>
+#include <cstdio>
+#include <functional>
+#include <memory>
 #include <string>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
 template <typename T>
@@ -47,10 +51,104 @@ void jsonSetMultimap(rapidjson::Document &doc,
                      const char (&name)[N],
                      FlatMultimap<std::string, T> &srcMap);
 
-// Helper functions for reading and writing JSON files.
+// Helper functions for reading and writing JSON files.  Pretty output puts each
+// array on one line, compact output has no whitespace at all.
+enum class JsonFormat {pretty, compact};
+
 rapidjson::Document jsonReadFile(const char *filename);
-void jsonWriteFile(const char *filename, const rapidjson::Document &doc);
+void jsonWriteFile(const char *filename,
+                   const rapidjson::Document &doc,
+                   JsonFormat format = JsonFormat::pretty);
+void jsonWriteFile(FILE *file,
+                   const rapidjson::Document &doc,
+                   JsonFormat format = JsonFormat::pretty);
+
+
+// Streaming alternative to jsonReadFile() followed by jsonGetArray() and
+// jsonGetMultimap(), for files made mostly of large integer arrays.  Tell it
+// where each top-level array should go, then read the file.  Values go straight
+// into the destinations as they're parsed, no document is built.  Anything not
+// registered is skipped.
+//
+// Example:
+//     JsonArrayReader reader;
+//     reader.addArray("tile-regions", regions);
+//     reader.addArray("tile-walkable", walkable, regions);  // same size
+//     reader.read(filename);
+class JsonArrayReader
+{
+public:
+    JsonArrayReader();
+    ~JsonArrayReader();
+
+    template <IntOrEnum T>
+    void addArray(const char *name, std::vector<T> &outVec);
+
+    // Reserve room for as many elements as 'sizeFrom' holds when the array
+    // starts.  Useful when the file stores several arrays of the same length.
+    template <IntOrEnum T, typename U>
+    void addArray(const char *name, std::vector<T> &outVec, const std::vector<U> &sizeFrom);
+
+    // Nested object containing arrays, as written by jsonSetMultimap().
+    void addMultimap(const char *name, FlatMultimap<std::string, int> &outMap);
+
+    // Throws std::runtime_error if the file is missing or doesn't parse, or if a
+    // registered array contains anything other than integers.
+    void read(const char *filename);
+
+private:
+    // Where to put the elements of one array.
+    class Sink
+    {
+    public:
+        virtual ~Sink() = default;
+        virtual void start() = 0;
+        virtual void push(int value) = 0;
+    };
+
+    template <IntOrEnum T>
+    class VectorSink;
+    class Handler;
+
+    std::vector<std::pair<std::string, std::unique_ptr<Sink>>> arrays_;
+    std::vector<std::pair<std::string, FlatMultimap<std::string, int> *>> multimaps_;
+};
+
+
+// Streaming counterpart to JsonArrayReader, for files too big to build as a
+// document first.  Writes one top-level object in the compact format.
+//
+// Example:
+//     JsonArrayWriter writer(filename);
+//     writer.startArray("tile-regions");
+//     for (int r : regions) {
+//         writer.push(r);
+//     }
+//     writer.endArray();
+//     writer.finish();
+class JsonArrayWriter
+{
+public:
+    // Throws std::runtime_error if the file can't be created.
+    explicit JsonArrayWriter(const char *filename);
+    ~JsonArrayWriter();
+
+    void startArray(const char *name);
+    void push(int value);
+    void endArray();
+
+    // Nested object containing arrays, as written by jsonSetMultimap().
+    void startObject(const char *name);
+    void endObject();
 
+    // Close the top-level object.  Throws std::runtime_error if the file
+    // couldn't be written.
+    void finish();
+
+private:
+    class Impl;
+    std::unique_ptr<Impl> impl_;
+};
 
 template <IntOrEnum T, size_t N>
 void jsonGetArray(rapidjson::Value &obj, const char (&name)[N], std::vector<T> &outVec)
@@ -82,6 +180,47 @@ void jsonSetArray(rapidjson::Document &doc, const char (&name)[N], const C &cont
     doc.AddMember(Value(name), ary, alloc);
 }
 
+template <IntOrEnum T>
+class JsonArrayReader::VectorSink : public JsonArrayReader::Sink
+{
+public:
+    VectorSink(std::vector<T> &outVec, std::function<size_t()> expectedSize)
+        : outVec_(&outVec),
+        expectedSize_(std::move(expectedSize))
+    {
+    }
+
+    void start() override
+    {
+        if (expectedSize_) {
+            outVec_->reserve(expectedSize_());
+        }
+    }
+
+    void push(int value) override { outVec_->push_back(static_cast<T>(value)); }
+
+private:
+    std::vector<T> *outVec_;
+    std::function<size_t()> expectedSize_;
+};
+
+template <IntOrEnum T>
+void JsonArrayReader::addArray(const char *name, std::vector<T> &outVec)
+{
+    arrays_.emplace_back(name, std::make_unique<VectorSink<T>>(outVec, nullptr));
+}
+
+template <IntOrEnum T, typename U>
+void JsonArrayReader::addArray(const char *name,
+                               std::vector<T> &outVec,
+                               const std::vector<U> &sizeFrom)
+{
+    // The other vector might not be filled in yet, check its size once this
+    // array starts.
+    auto expectedSize = [&sizeFrom] { return sizeFrom.size(); };
+    arrays_.emplace_back(name, std::make_unique<VectorSink<T>>(outVec, expectedSize));
+}
+
 template <std::integral T, size_t N>
 void jsonGetMultimap(rapidjson::Value &obj,
                      const char (&name)[N],
@@ -0,0 +1,51 @@
+/*
+    Copyright (C) 2025 by Michael Kristofik <kristo605@gmail.com>
+    Part of the Champions of Anduran project.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    or at your option any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY.
+
+    See the COPYING.txt file for more details.
+*/
+#ifndef MAP_FILE_FORMAT_H
+#define MAP_FILE_FORMAT_H
+
+#include "binary_utils.h"
+#include <cstdint>
+
+// Binary map files, shared by everything that reads or writes them.  Bump the
+// version whenever the meaning of any section changes.
+struct MapFile
+{
+    static constexpr BinaryMagic magic = {'A', 'N', 'D', 'U', 'R', 'M', 'A', 'P'};
+    static constexpr uint32_t version = 1;
+
+    enum Section : uint32_t
+    {
+        tileRegions = 1,
+        regionTerrain,
+        tileObstacles,  // packed bits
+        tileOccupied,
+        tileWalkable,
+        castles,
+        regionCastleDistance,
+        objectOffsets,  // where each ObjectType starts in objectTiles
+        objectTiles,
+        tileRegionNeighbors,  // frozen multimap key-value pairs
+        regionNeighbors,
+        // checkpoints only
+        stageInfo,  // last stage finished, seed
+        randomState,  // random engine, as text
+        borderTiles,  // pairs of tiles
+        regionLandmass,
+        coastLandmasses,  // pairs of landmasses
+        coastTerrain,  // bitset of terrain types
+        coastTileOffsets,  // where each coastline starts in coastTiles
+        coastTiles
+    };
+};
+
+#endif
@@ -10,6 +10,7 @@
 
     See the COPYING.txt file for more details.
 */
+#include "MapCache.h"
 #include "MapDisplay.h"
 #include "Minimap.h"
 #include "ObjectImages.h"
@@ -32,7 +33,7 @@ using namespace std::string_literals;
 class MapViewApp : public SdlApp
 {
 public:
-    explicit MapViewApp(const char *filename);
+    MapViewApp(const MapArgs &args, const char *filename);
 
     void update_frame(Uint32) override;
     void handle_mouse_pos(Uint32 elapsed_ms) override;
@@ -56,12 +57,12 @@ private:
     Minimap minimap_;
 };
 
-MapViewApp::MapViewApp(const char *filename)
+MapViewApp::MapViewApp(const MapArgs &args, const char *filename)
     : SdlApp(),
     config_("data/window.json"s),
     win_(config_.width(), config_.height(), "Anduran Map Viewer"),
     objs_("data/objects.json"s),
-    rmap_(filename, objs_),
+    rmap_(load_map(args, filename, objs_)),
     images_("img/"),
     objImg_(images_, objs_, win_),
     rmapView_(win_, config_.map_bounds(), rmap_, images_),
@@ -145,14 +146,15 @@ void MapViewApp::place_armies()
 }
 
 
+// usage: mapview [filename | -s seed [-w width]]
 int main(int argc, char *argv[])
 {
     // Default to the same filename used by rmapgen.
     const char *filename = "test2.json";
-    if (argc >= 2) {
+    if (argc == 2) {
         filename = argv[1];
     }
 
-    MapViewApp app(filename);
+    MapViewApp app(parse_map_args(argc, argv), filename);
     return app.run();
 }
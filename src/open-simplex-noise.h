@@ -41,6 +41,14 @@ int open_simplex_noise(int64_t seed, struct osn_context **ctx);
 void open_simplex_noise_free(struct osn_context *ctx);
 int open_simplex_noise_init_perm(struct osn_context *ctx, int16_t p[], int nelements);
 double open_simplex_noise2(const struct osn_context *ctx, double x, double y);
+
+/*
+ * Fill a width x height grid of 2D noise values in row-major order:
+ *   out[j * width + i] = open_simplex_noise2(ctx, (x0 + i) / featureSize,
+ *                                                 (y0 + j) / featureSize)
+ * The results are identical to calling open_simplex_noise2 for each point.
+ */
+void open_simplex_noise2_grid(const struct osn_context *ctx, int x0, int y0, int width, int height, double featureSize, double *out);
 double open_simplex_noise3(const struct osn_context *ctx, double x, double y, double z);
 double open_simplex_noise4(const struct osn_context *ctx, double x, double y, double z, double w);
 
@@ -0,0 +1,100 @@
+/*
+    Copyright (C) 2025 by Michael Kristofik <kristo605@gmail.com>
+    Part of the Champions of Anduran project.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    or at your option any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY.
+
+    See the COPYING.txt file for more details.
+*/
+#include "profile_utils.h"
+
+#include <atomic>
+
+#ifdef _WIN32
+#define PSAPI_VERSION 2  // use the version in kernel32, no extra library needed
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+namespace
+{
+    // These can be touched before main() starts, so they must not need any
+    // dynamic initialization.
+    constinit std::atomic<bool> trackingEnabled = false;
+    constinit std::atomic<int64_t> allocCount = 0;
+    constinit std::atomic<int64_t> allocBytes = 0;
+    constinit std::atomic<int64_t> allocInUse = 0;
+    constinit std::atomic<int64_t> allocPeak = 0;
+}
+
+
+bool alloc_tracking_enabled()
+{
+    return trackingEnabled;
+}
+
+AllocStats alloc_stats()
+{
+    return {allocCount, allocBytes, allocInUse};
+}
+
+int64_t alloc_peak()
+{
+    return allocPeak;
+}
+
+void alloc_peak_reset()
+{
+    allocPeak = allocInUse.load();
+}
+
+void alloc_enable_tracking()
+{
+    trackingEnabled = true;
+}
+
+void alloc_record_new(std::size_t bytes)
+{
+    const auto size = static_cast<int64_t>(bytes);
+    allocCount.fetch_add(1, std::memory_order_relaxed);
+    allocBytes.fetch_add(size, std::memory_order_relaxed);
+    const auto inUse = allocInUse.fetch_add(size, std::memory_order_relaxed) + size;
+
+    auto peak = allocPeak.load(std::memory_order_relaxed);
+    while (inUse > peak &&
+           !allocPeak.compare_exchange_weak(peak, inUse, std::memory_order_relaxed))
+    {
+    }
+}
+
+void alloc_record_delete(std::size_t bytes)
+{
+    allocInUse.fetch_sub(static_cast<int64_t>(bytes), std::memory_order_relaxed);
+}
+
+int64_t peak_rss_kb()
+{
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return 0;
+    }
+    return counters.PeakWorkingSetSize / 1024;
+#else
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+#ifdef __APPLE__
+    return usage.ru_maxrss / 1024;  // reported in bytes
+#else
+    return usage.ru_maxrss;
+#endif
+#endif
+}
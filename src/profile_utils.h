@@ -0,0 +1,102 @@
+/*
+    Copyright (C) 2025 by Michael Kristofik <kristo605@gmail.com>
+    Part of the Champions of Anduran project.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    or at your option any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY.
+
+    See the COPYING.txt file for more details.
+*/
+#ifndef PROFILE_UTILS_H
+#define PROFILE_UTILS_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Heap usage for the whole process.  These only count anything in programs
+// that link alloc_hooks.cpp, which replaces the global operator new and
+// delete.  Everywhere else they're always zero.
+struct AllocStats
+{
+    int64_t count = 0;  // number of allocations so far
+    int64_t bytes = 0;  // total bytes allocated so far
+    int64_t inUse = 0;  // bytes currently allocated
+};
+
+bool alloc_tracking_enabled();
+AllocStats alloc_stats();
+
+// Highest 'inUse' value since the last reset.
+int64_t alloc_peak();
+void alloc_peak_reset();
+
+// Called by the allocation hooks.
+void alloc_enable_tracking();
+void alloc_record_new(std::size_t bytes);
+void alloc_record_delete(std::size_t bytes);
+
+// Largest resident set size the process has had so far, in kilobytes.
+int64_t peak_rss_kb();
+
+
+// Measurements for one step of a longer process.  Heap stats are process-wide,
+// so they include anything other threads did at the same time.
+struct PhaseStats
+{
+    std::string name;
+    double wallMs = 0.0;
+    int64_t allocs = 0;
+    int64_t allocBytes = 0;
+    int64_t peakHeapBytes = 0;  // most extra heap in use at any one time
+};
+
+
+// Run a sequence of steps, recording stats for each one.
+class PhaseProfiler
+{
+public:
+    template <typename F>
+    void run(std::string name, F &&func);
+
+    const std::vector<PhaseStats> & phases() const;
+
+private:
+    std::vector<PhaseStats> phases_;
+};
+
+
+template <typename F>
+void PhaseProfiler::run(std::string name, F &&func)
+{
+    PhaseStats stats;
+    stats.name = std::move(name);
+
+    const auto before = alloc_stats();
+    alloc_peak_reset();
+    const auto start = std::chrono::steady_clock::now();
+
+    func();
+
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    const auto after = alloc_stats();
+    stats.wallMs = std::chrono::duration<double, std::milli>(elapsed).count();
+    stats.allocs = after.count - before.count;
+    stats.allocBytes = after.bytes - before.bytes;
+    stats.peakHeapBytes = alloc_peak() - before.inUse;
+
+    phases_.push_back(std::move(stats));
+}
+
+inline const std::vector<PhaseStats> & PhaseProfiler::phases() const
+{
+    return phases_;
+}
+
+#endif
@@ -1,5 +1,5 @@
 /*
-    Copyright (C) 2016-2024 by Michael Kristofik <kristo605@gmail.com>
+    Copyright (C) 2016-2025 by Michael Kristofik <kristo605@gmail.com>
     Part of the Champions of Anduran project.
  
     This program is free software; you can redistribute it and/or modify
@@ -10,14 +10,188 @@
  
     See the COPYING.txt file for more details.
 */
+#include "ChunkedMapGenerator.h"
+#include "MapCache.h"
 #include "ObjectManager.h"
 #include "RandomMap.h"
+#include "fairness_utils.h"
+#include "json_utils.h"
+#include "log_utils.h"
+#include "profile_utils.h"
+
+#include "rapidjson/document.h"
+
+#include <algorithm>
+#include <cstdio>
 #include <cstdlib>
+#include <format>
+#include <optional>
+#include <random>
+#include <string_view>
 
-int main()
+namespace
 {
+    void write_profile(const RandomMap &map, const MapArgs &args)
+    {
+        using namespace rapidjson;
+
+        Document doc(kObjectType);
+        auto &alloc = doc.GetAllocator();
+        doc.AddMember("seed", map.seed(), alloc);
+        doc.AddMember("width", map.width(), alloc);
+        doc.AddMember("threads", args.numThreads, alloc);
+        doc.AddMember("alloc-tracking", alloc_tracking_enabled(), alloc);
+
+        Value phases(kArrayType);
+        double totalMs = 0.0;
+        for (auto &stats : map.getProfile()) {
+            Value phase(kObjectType);
+            phase.AddMember("name", Value(stats.name.c_str(), alloc), alloc);
+            phase.AddMember("ms", stats.wallMs, alloc);
+            phase.AddMember("allocs", stats.allocs, alloc);
+            phase.AddMember("alloc-bytes", stats.allocBytes, alloc);
+            phase.AddMember("peak-heap-bytes", stats.peakHeapBytes, alloc);
+            phases.PushBack(phase, alloc);
+            totalMs += stats.wallMs;
+        }
+        doc.AddMember("total-ms", totalMs, alloc);
+        doc.AddMember("peak-rss-kb", peak_rss_kb(), alloc);
+        doc.AddMember("phases", phases, alloc);
+
+        jsonWriteFile(stdout, doc);
+        std::fputc('\n', stdout);
+    }
+}
+
+
+// usage: rmapgen [-s seed] [-w width] [-j threads] [--profile] [--binary]
+//                [--checkpoints] [--resume file [--reroll seed]] [--best-of n]
+//                [--chunk-rows n]
+// Maps generated with an explicit seed are also saved to the map cache.
+// --binary writes test2.map in the binary map format instead of test2.json.
+// --profile always generates a new map, and prints the time and memory spent
+// on each step as JSON.
+// --checkpoints always generates a new map, saving a checkpoint after each
+// stage as test2-<stage>.ckpt.
+// --resume finishes a map from a checkpoint, running only the later stages.
+// --reroll gives those stages a new seed, e.g. to try different objects on the
+// same terrain.
+// --best-of generates n maps, one per thread at a time, and saves the one that
+// gives every player the fairest start.
+// --chunk-rows generates the map n rows at a time, for maps too big to fit in
+// memory.  Those maps have castles but no other objects.  Always generates a
+// new map.
+int main(int argc, char *argv[])
+{
+    auto args = parse_map_args(argc, argv);
+    bool profile = false;
+    bool binary = false;
+    bool checkpoints = false;
+    const char *resumeFile = nullptr;
+    std::optional<unsigned int> rerollSeed;
+    int bestOf = 0;
+    int chunkRows = 0;
+    for (int i = 1; i < argc; ++i) {
+        std::string_view arg = argv[i];
+        if (arg == "--profile") {
+            profile = true;
+        }
+        else if (arg == "--binary") {
+            binary = true;
+        }
+        else if (arg == "--checkpoints") {
+            checkpoints = true;
+        }
+        else if (arg == "--resume" && i + 1 < argc) {
+            resumeFile = argv[++i];
+        }
+        else if (arg == "--reroll" && i + 1 < argc) {
+            rerollSeed = std::strtoul(argv[++i], nullptr, 10);
+        }
+        else if (arg == "--best-of" && i + 1 < argc) {
+            bestOf = std::max(std::atoi(argv[++i]), 1);
+        }
+        else if (arg == "--chunk-rows" && i + 1 < argc) {
+            chunkRows = std::max(std::atoi(argv[++i]), 1);
+        }
+    }
+
+    auto save = [binary] (RandomMap &map) {
+        if (binary) {
+            map.writeBinaryFile("test2.map");
+        }
+        else {
+            map.writeFile("test2.json");
+        }
+    };
+
+    RandomMap::StageCallback onStageDone;
+    if (checkpoints) {
+        onStageDone = [] (RandomMap &map, MapStage stage) {
+            if (stage != MapStage::objects) {
+                auto filename = std::format("test2-{}.ckpt", str_from_MapStage(stage));
+                map.writeCheckpoint(filename.c_str());
+            }
+        };
+    }
+
+    if (chunkRows > 0) {
+        auto seed = args.seed.value_or(std::random_device()());
+        log_info(std::format("map seed {}", seed));
+        ChunkedMapGenerator gen(args.width, seed, chunkRows, args.numThreads);
+        PhaseProfiler profiler;
+        profiler.run("generate", [&gen, binary] {
+            if (binary) {
+                gen.writeBinaryFile("test2.map");
+            }
+            else {
+                gen.writeJsonFile("test2.json");
+            }
+        });
+        log_info(std::format("{} rows at a time: {:.0f} ms, peak RSS {} KB",
+                             gen.bandRows(), profiler.phases()[0].wallMs,
+                             peak_rss_kb()));
+        return EXIT_SUCCESS;
+    }
+
     ObjectManager objs("data/objects.json");
-    RandomMap map(36, objs);
-    map.writeFile("test2.json");
+
+    if (resumeFile) {
+        auto map = RandomMap::resume(resumeFile, objs, rerollSeed, args.numThreads,
+                                     onStageDone);
+        save(map);
+        if (profile) {
+            write_profile(map, args);
+        }
+    }
+    else if (bestOf > 0) {
+        auto seed = args.seed.value_or(std::random_device()());
+        auto result = fairest_map(args.width, seed, bestOf, objs, args.numThreads);
+        for (auto &c : result.candidates) {
+            log_info(std::format("candidate seed {} fairness score {:.3f}",
+                                 c.seed, c.score));
+        }
+        log_info(std::format("best map seed {}",
+                             result.candidates[result.best].seed));
+        save(result.map);
+        if (profile) {
+            write_profile(result.map, args);
+        }
+    }
+    else if (args.seed && !profile && !checkpoints) {
+        MapCache cache("cache", "data/objects.json");
+        auto map = cache.get(*args.seed, args.width, objs, args.numThreads);
+        save(map);
+    }
+    else {
+        auto seed = args.seed.value_or(std::random_device()());
+        log_info(std::format("map seed {}", seed));
+        RandomMap map(args.width, seed, objs, args.numThreads, onStageDone);
+        save(map);
+        if (profile) {
+            write_profile(map, args);
+        }
+    }
+
     return EXIT_SUCCESS;
 }
@@ -0,0 +1,184 @@
+/*
+    Copyright (C) 2025 by Michael Kristofik <kristo605@gmail.com>
+    Part of the Champions of Anduran project.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    or at your option any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY.
+
+    See the COPYING.txt file for more details.
+*/
+#include "ObjectManager.h"
+#include "RandomMap.h"
+#include "json_utils.h"
+#include "log_utils.h"
+#include "profile_utils.h"
+
+#include "rapidjson/document.h"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <format>
+#include <string_view>
+#include <vector>
+
+namespace
+{
+    const std::vector<int> DEFAULT_WIDTHS = {36, 72, 144, 288, 576};
+    const int DEFAULT_SEEDS = 10;
+
+    struct BenchArgs
+    {
+        std::vector<int> widths;
+        int numSeeds = DEFAULT_SEEDS;
+        int numThreads = 1;
+    };
+
+    BenchArgs parse_args(int argc, char *argv[])
+    {
+        BenchArgs args;
+        for (int i = 1; i + 1 < argc; ++i) {
+            std::string_view arg = argv[i];
+            if (arg == "-w") {
+                args.widths.push_back(std::atoi(argv[++i]));
+            }
+            else if (arg == "-n") {
+                args.numSeeds = std::max(std::atoi(argv[++i]), 1);
+            }
+            else if (arg == "-j") {
+                args.numThreads = std::atoi(argv[++i]);
+            }
+        }
+
+        if (args.widths.empty()) {
+            args.widths = DEFAULT_WIDTHS;
+        }
+        return args;
+    }
+
+    // Nearest-rank method, p in the range [0, 100].
+    double percentile(std::vector<double> values, double p)
+    {
+        assert(!values.empty());
+        std::ranges::sort(values);
+        const int rank = std::ceil(p / 100.0 * ssize(values));
+        return values[std::clamp(rank, 1, static_cast<int>(ssize(values))) - 1];
+    }
+
+    // Add a timing summary of several runs of the same thing to a JSON object.
+    void add_summary(rapidjson::Value &obj,
+                     const std::vector<double> &ms,
+                     rapidjson::Document::AllocatorType &alloc)
+    {
+        obj.AddMember("median-ms", percentile(ms, 50), alloc);
+        obj.AddMember("p95-ms", percentile(ms, 95), alloc);
+        obj.AddMember("max-ms", std::ranges::max(ms), alloc);
+    }
+
+    // Every run at one width.
+    struct WidthRuns
+    {
+        std::vector<double> totalMs;
+        std::vector<std::vector<double>> phaseMs;  // [phase][run]
+        std::vector<std::vector<double>> phaseAllocs;
+        std::vector<std::string> phaseNames;
+        int64_t peakHeapBytes = 0;
+    };
+
+    WidthRuns run_width(int width, const BenchArgs &args, const ObjectManager &objs)
+    {
+        WidthRuns runs;
+
+        // Same seeds every time so results are comparable across builds.
+        for (int s = 1; s <= args.numSeeds; ++s) {
+            const auto heapBefore = alloc_stats().inUse;
+            alloc_peak_reset();
+            const auto start = std::chrono::steady_clock::now();
+
+            RandomMap map(width, s, objs, args.numThreads);
+
+            const auto elapsed = std::chrono::steady_clock::now() - start;
+            runs.totalMs.push_back(
+                std::chrono::duration<double, std::milli>(elapsed).count());
+            runs.peakHeapBytes = std::max(runs.peakHeapBytes,
+                                          alloc_peak() - heapBefore);
+
+            const auto &phases = map.getProfile();
+            runs.phaseMs.resize(phases.size());
+            runs.phaseAllocs.resize(phases.size());
+            runs.phaseNames.resize(phases.size());
+            for (int p = 0; p < ssize(phases); ++p) {
+                runs.phaseNames[p] = phases[p].name;
+                runs.phaseMs[p].push_back(phases[p].wallMs);
+                runs.phaseAllocs[p].push_back(phases[p].allocs);
+            }
+        }
+
+        return runs;
+    }
+}
+
+
+// usage: rmapgen-bench [-w width]... [-n seeds] [-j threads]
+// Generate maps for a range of widths using seeds 1 through N.  Print timing
+// and memory statistics as JSON, overall and for each phase of generation.
+// Progress goes to stderr.
+int main(int argc, char *argv[])
+{
+    using namespace rapidjson;
+
+    const auto args = parse_args(argc, argv);
+    ObjectManager objs("data/objects.json");
+
+    Document doc(kObjectType);
+    auto &alloc = doc.GetAllocator();
+    doc.AddMember("seeds", args.numSeeds, alloc);
+    doc.AddMember("threads", args.numThreads, alloc);
+    doc.AddMember("alloc-tracking", alloc_tracking_enabled(), alloc);
+
+    Value results(kArrayType);
+    for (int width : args.widths) {
+        log_info(std::format("width {}, {} seeds", width, args.numSeeds));
+        auto runs = run_width(width, args, objs);
+
+        Value result(kObjectType);
+        result.AddMember("width", width, alloc);
+        result.AddMember("tiles", width * width, alloc);
+        Value total(kObjectType);
+        add_summary(total, runs.totalMs, alloc);
+        result.AddMember("total", total, alloc);
+
+        // Time per thousand tiles should stay roughly flat as the map grows.
+        const double ktiles = width * width / 1000.0;
+        result.AddMember("median-ms-per-ktile", percentile(runs.totalMs, 50) / ktiles,
+                         alloc);
+        result.AddMember("peak-heap-bytes", runs.peakHeapBytes, alloc);
+        // The OS only tracks the high-water mark for the whole process, so this
+        // stops changing after the largest width so far.  Use peak-heap-bytes
+        // to compare widths.
+        result.AddMember("cumulative-peak-rss-kb", peak_rss_kb(), alloc);
+
+        Value phases(kArrayType);
+        for (int p = 0; p < ssize(runs.phaseNames); ++p) {
+            Value phase(kObjectType);
+            phase.AddMember("name", Value(runs.phaseNames[p].c_str(), alloc), alloc);
+            add_summary(phase, runs.phaseMs[p], alloc);
+            const auto allocs = percentile(runs.phaseAllocs[p], 50);
+            phase.AddMember("median-allocs", static_cast<int64_t>(allocs), alloc);
+            phases.PushBack(phase, alloc);
+        }
+        result.AddMember("phases", phases, alloc);
+        results.PushBack(result, alloc);
+    }
+    doc.AddMember("results", results, alloc);
+
+    jsonWriteFile(stdout, doc);
+    std::fputc('\n', stdout);
+    return EXIT_SUCCESS;
+}
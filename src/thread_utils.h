@@ -0,0 +1,103 @@
+/*
+    Copyright (C) 2025 by Michael Kristofik <kristo605@gmail.com>
+    Part of the Champions of Anduran project.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    or at your option any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY.
+
+    See the COPYING.txt file for more details.
+*/
+#ifndef THREAD_UTILS_H
+#define THREAD_UTILS_H
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <thread>
+#include <vector>
+
+// An exception escaping a worker thread would call std::terminate.  Each
+// thread catches its own instead, and the calling thread rethrows the first one
+// (in thread order) after they've all finished.
+inline void rethrow_first(const std::vector<std::exception_ptr> &errors)
+{
+    for (auto &e : errors) {
+        if (e) {
+            std::rethrow_exception(e);
+        }
+    }
+}
+
+
+// Split the range [0, count) into contiguous blocks, one per thread, and call
+// func(begin, end, block) for each of them.  The calling thread runs the first
+// block itself.  Returns once every block is finished.
+template <typename F>
+void parallel_blocks(int count, int numThreads, F &&func)
+{
+    numThreads = std::clamp(numThreads, 1, std::max(count, 1));
+
+    auto blockBegin = [count, numThreads] (int block) {
+        return static_cast<int>(static_cast<long long>(count) * block / numThreads);
+    };
+
+    std::vector<std::exception_ptr> errors(numThreads);
+    auto runBlock = [&func, &blockBegin, &errors] (int b) {
+        try {
+            func(blockBegin(b), blockBegin(b + 1), b);
+        }
+        catch (...) {
+            errors[b] = std::current_exception();
+        }
+    };
+
+    std::vector<std::jthread> workers;
+    workers.reserve(numThreads - 1);
+    for (int b = 1; b < numThreads; ++b) {
+        workers.emplace_back(runBlock, b);
+    }
+
+    runBlock(0);
+    workers.clear();  // jthread joins on destruction
+    rethrow_first(errors);
+}
+
+// Call func(i) for every i in [0, count), handing out one task at a time to
+// whichever thread is free next.  Better than parallel_blocks() when tasks take
+// very different amounts of time.  The order tasks run in isn't predictable, so
+// func shouldn't depend on it.  Returns once every task is finished.  After a
+// task throws, no new tasks are started.
+template <typename F>
+void parallel_tasks(int count, int numThreads, F &&func)
+{
+    numThreads = std::clamp(numThreads, 1, std::max(count, 1));
+    std::atomic<int> next = 0;
+
+    std::vector<std::exception_ptr> errors(numThreads);
+    auto worker = [&func, &next, &errors, count] (int t) {
+        try {
+            for (int i = next++; i < count; i = next++) {
+                func(i);
+            }
+        }
+        catch (...) {
+            errors[t] = std::current_exception();
+            next = count;
+        }
+    };
+
+    std::vector<std::jthread> workers;
+    workers.reserve(numThreads - 1);
+    for (int t = 1; t < numThreads; ++t) {
+        workers.emplace_back(worker, t);
+    }
+
+    worker(0);
+    workers.clear();
+    rethrow_first(errors);
+}
+
+#endif
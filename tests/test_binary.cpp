@@ -0,0 +1,45 @@
+/*
+    Copyright (C) 2025 by Michael Kristofik <kristo605@gmail.com>
+    Part of the Champions of Anduran project.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    or at your option any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY.
+
+    See the COPYING.txt file for more details.
+*/
+#include <boost/test/unit_test.hpp>
+
+#include "binary_utils.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <stdexcept>
+
+namespace
+{
+    const BinaryMagic TEST_MAGIC = {'A', 'N', 'D', 'T', 'E', 'S', 'T', '\0'};
+}
+
+BOOST_AUTO_TEST_CASE(missing_binary_files)
+{
+    const auto path = std::filesystem::temp_directory_path() / "anduran_no_such_file.bin";
+    std::filesystem::remove(path);
+    BOOST_TEST(!BinaryFileReader::matches(path.string().c_str(), TEST_MAGIC));
+}
+
+BOOST_AUTO_TEST_CASE(unwritable_binary_files)
+{
+    // Can't open a directory for writing, even as root.
+    const auto dir = std::filesystem::temp_directory_path().string();
+    BinaryFileWriter writer(TEST_MAGIC, 1);
+    BOOST_CHECK_THROW(writer.write(dir.c_str()), std::runtime_error);
+
+    const BinaryStreamWriter::SectionSize sections[] = {
+        BinaryStreamWriter::sectionSize<int32_t>(1, 10)
+    };
+    BOOST_CHECK_THROW(BinaryStreamWriter(dir.c_str(), TEST_MAGIC, 1, sections),
+                      std::runtime_error);
+}
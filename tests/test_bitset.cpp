@@ -0,0 +1,59 @@
+/*
+    Copyright (C) 2025 by Michael Kristofik <kristo605@gmail.com>
+    Part of the Champions of Anduran project.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    or at your option any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY.
+
+    See the COPYING.txt file for more details.
+*/
+#include <boost/test/unit_test.hpp>
+
+#include "TileBitset.h"
+
+#include <vector>
+
+BOOST_AUTO_TEST_CASE(tile_bitset)
+{
+    // Odd size so the last word is only partly used.
+    TileBitset walkable(130, true);
+    BOOST_TEST(walkable.count() == 130);
+
+    const std::vector<int> flags = {0, 1, 0, 0, 1};
+    TileBitset small(flags);
+    BOOST_TEST(small.size() == 5);
+    BOOST_TEST(small.count() == 2);
+    BOOST_TEST(small.toVector() == (std::vector<signed char>{0, 1, 0, 0, 1}),
+               boost::test_tools::per_element());
+
+    TileBitset occupied(130);
+    occupied.set(0);
+    occupied.set(64);
+    occupied.set(129);
+    walkable.reset(5);
+    walkable.reset(64);
+
+    // Walkable and not occupied.
+    auto open = walkable;
+    open.andNot(occupied);
+    BOOST_TEST(open.count() == 126);
+    BOOST_TEST(!open[0]);
+    BOOST_TEST(open[1]);
+
+    // Flipping mustn't set bits past the end.
+    auto blocked = open;
+    blocked.flip();
+    BOOST_TEST(blocked.count() == 4);
+    std::vector<int> setBits;
+    blocked.forEachSet([&setBits] (int i) { setBits.push_back(i); });
+    const int expected[] = {0, 5, 64, 129};
+    BOOST_TEST(setBits == expected, boost::test_tools::per_element());
+    BOOST_TEST((open | blocked).count() == 130);
+    BOOST_TEST((open & blocked).count() == 0);
+
+    const int someTiles[] = {0, 1, 5, 6};
+    BOOST_TEST(open.count(someTiles) == 2);
+}
@@ -0,0 +1,32 @@
+/*
+    Copyright (C) 2025 by Michael Kristofik <kristo605@gmail.com>
+    Part of the Champions of Anduran project.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    or at your option any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY.
+
+    See the COPYING.txt file for more details.
+*/
+#include <boost/test/unit_test.hpp>
+
+#include "DisjointSets.h"
+
+BOOST_AUTO_TEST_CASE(disjoint_sets)
+{
+    DisjointSets sets(6);
+    BOOST_TEST(sets.size() == 6);
+    BOOST_TEST(!sets.same(0, 1));
+    BOOST_TEST(sets.setSize(0) == 1);
+
+    BOOST_TEST(sets.join(0, 1));
+    BOOST_TEST(sets.join(2, 3));
+    BOOST_TEST(sets.join(3, 1));
+    BOOST_TEST(!sets.join(0, 2));  // already joined
+    BOOST_TEST(sets.same(0, 3));
+    BOOST_TEST(sets.setSize(2) == 4);
+    BOOST_TEST(!sets.same(4, 5));
+    BOOST_TEST(sets.setSize(5) == 1);
+}
@@ -0,0 +1,166 @@
+/*
+    Copyright (C) 2025 by Michael Kristofik <kristo605@gmail.com>
+    Part of the Champions of Anduran project.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    or at your option any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY.
+
+    See the COPYING.txt file for more details.
+*/
+#include <boost/test/unit_test.hpp>
+
+#include "RandomRange.h"
+#include "hex_kernels.h"
+#include "hex_utils.h"
+
+#include <algorithm>
+#include <limits>
+#include <string>
+#include <vector>
+
+BOOST_AUTO_TEST_CASE(batch_distance)
+{
+    // Cover both column parities, negative coordinates, and a length that
+    // doesn't fill the last SIMD register.
+    HexArray hexes;
+    for (int x = -5; x <= 6; ++x) {
+        for (int y = -4; y <= 6; ++y) {
+            hexes.x.push_back(x);
+            hexes.y.push_back(y);
+        }
+    }
+    BOOST_TEST_REQUIRE(hexes.size() % 8 != 0);
+
+    const std::vector<Hex> sources = {{0, 0}, {3, 2}, {-3, 1}, {-2, -4}, {5, 6}};
+    const std::vector<Hex> centers = {{1, 1}, {-3, 4}, {4, -2}, {1, 1}, {5, 5}};
+    std::vector<int> expectedClosest;
+    for (int i = 0; i < hexes.size(); ++i) {
+        expectedClosest.push_back(hexClosestIdx(hexes[i], centers));
+    }
+
+    std::vector<int> dist(hexes.size());
+    for (const Hex &src : sources) {
+        hexDistances(src, hexes, dist);
+        for (int i = 0; i < hexes.size(); ++i) {
+            BOOST_TEST(dist[i] == hexDistance(src, hexes[i]));
+        }
+    }
+    BOOST_TEST(hexClosestIdx(hexes, centers) == expectedClosest,
+               boost::test_tools::per_element());
+    BOOST_TEST_MESSAGE("batch distance kernel: " << hexDistanceKernel());
+
+    // The functions above only use the fastest version, check the others too.
+    const auto kernels = hexDistanceKernels();
+    BOOST_TEST(kernels.front().name == hexDistanceKernel());
+    BOOST_TEST(kernels.back().name == std::string("scalar"));
+    for (auto &kernel : kernels) {
+        BOOST_TEST_CONTEXT("kernel " << kernel.name) {
+            for (const Hex &src : sources) {
+                std::ranges::fill(dist, -1);
+                kernel.distances(HexDistSource(src), hexes.x.data(), hexes.y.data(),
+                                 hexes.size(), dist.data());
+                for (int i = 0; i < hexes.size(); ++i) {
+                    BOOST_TEST(dist[i] == hexDistance(src, hexes[i]));
+                }
+            }
+
+            std::vector<int> nearestDist(hexes.size(), std::numeric_limits<int>::max());
+            std::vector<int> nearestIdx(hexes.size(), -1);
+            for (int c = 0; c < ssize(centers); ++c) {
+                kernel.nearest(HexDistSource(centers[c]), c, hexes.x.data(),
+                               hexes.y.data(), hexes.size(), nearestDist.data(),
+                               nearestIdx.data());
+            }
+            BOOST_TEST(nearestIdx == expectedClosest, boost::test_tools::per_element());
+            for (int i = 0; i < hexes.size(); ++i) {
+                BOOST_TEST(nearestDist[i] == hexDistance(hexes[i], centers[nearestIdx[i]]));
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(closest_idx_grid)
+{
+    const int width = 20;
+    RandomRange randCoord(0, width - 1);
+
+    // Include some duplicate centers to exercise the tie-breaking rule.
+    std::vector<Hex> centers(12);
+    std::ranges::generate(centers, [&randCoord] {
+        return Hex{randCoord.get(), randCoord.get()};
+    });
+    centers.push_back(centers[3]);
+    centers.push_back(centers[0]);
+
+    auto closest = hexClosestIdxGrid(width, centers);
+    BOOST_TEST(ssize(closest) == width * width);
+    for (int i = 0; i < width * width; ++i) {
+        Hex hex(i % width, i / width);
+        BOOST_TEST(closest[i] == hexClosestIdx(hex, centers));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(closest_idx_grid_threads)
+{
+    const int width = 50;
+    RandomRange randCoord(0, width - 1);
+    std::vector<Hex> centers(40);
+    std::ranges::generate(centers, [&randCoord] {
+        return Hex{randCoord.get(), randCoord.get()};
+    });
+
+    auto serial = hexClosestIdxGrid(width, centers);
+    for (int numThreads : {2, 3, 7}) {
+        BOOST_TEST(hexClosestIdxGrid(width, centers, numThreads) == serial);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(clusters)
+{
+    // Puzzle pieces are clusters of a rectangle of hexes.
+    std::vector<Hex> hexes;
+    for (int x = 0; x < 12; ++x) {
+        for (int y = 0; y < 10; ++y) {
+            hexes.emplace_back(x, y);
+        }
+    }
+
+    const unsigned int seed = 42;
+    std::vector<int> serial;
+    {
+        ScopedRandomSeed scopedSeed(seed);
+        serial = hexClusters(hexes, 6);
+    }
+    BOOST_TEST(ssize(serial) == ssize(hexes));
+    for (int c = 0; c < 6; ++c) {
+        BOOST_TEST(std::ranges::count(serial, c) > 0);
+    }
+
+    // Same seed, same clusters, no matter how many threads.
+    for (int numThreads : {1, 2, 3, 7}) {
+        ScopedRandomSeed scopedSeed(seed);
+        BOOST_TEST(hexClusters(hexes, 6, numThreads) == serial);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(tile_neighbors)
+{
+    const int width = 7;
+    for (int i = 0; i < width * width; ++i) {
+        const Hex hex(i % width, i / width);
+        std::vector<int> expected;
+        for (auto d : HexDir()) {
+            const Hex hNbr = hex.getNeighbor(d);
+            if (hNbr.x >= 0 && hNbr.x < width && hNbr.y >= 0 && hNbr.y < width) {
+                expected.push_back(hNbr.y * width + hNbr.x);
+            }
+        }
+        std::ranges::sort(expected);
+
+        const TileNeighbors nbrs(i, width);
+        BOOST_TEST(std::vector<int>(nbrs.begin(), nbrs.end()) == expected);
+    }
+}
@@ -0,0 +1,41 @@
+/*
+    Copyright (C) 2025 by Michael Kristofik <kristo605@gmail.com>
+    Part of the Champions of Anduran project.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    or at your option any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY.
+
+    See the COPYING.txt file for more details.
+*/
+#include <boost/test/unit_test.hpp>
+
+#include "json_utils.h"
+
+#include <filesystem>
+#include <stdexcept>
+#include <vector>
+
+BOOST_AUTO_TEST_CASE(missing_json_files)
+{
+    const auto path = std::filesystem::temp_directory_path() / "anduran_no_such_file.json";
+    std::filesystem::remove(path);
+
+    std::vector<int> values;
+    JsonArrayReader reader;
+    reader.addArray("values", values);
+    BOOST_CHECK_THROW(reader.read(path.string().c_str()), std::runtime_error);
+    BOOST_CHECK_THROW(jsonReadFile(path.string().c_str()), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(unwritable_json_files)
+{
+    // Can't open a directory for writing, even as root.
+    const auto dir = std::filesystem::temp_directory_path().string();
+    BOOST_CHECK_THROW(JsonArrayWriter writer(dir.c_str()), std::runtime_error);
+
+    rapidjson::Document doc(rapidjson::kObjectType);
+    BOOST_CHECK_THROW(jsonWriteFile(dir.c_str(), doc), std::runtime_error);
+}
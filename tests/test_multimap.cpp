@@ -1,5 +1,5 @@
 /*
-    Copyright (C) 2021 by Michael Kristofik <kristo605@gmail.com>
+    Copyright (C) 2021-2025 by Michael Kristofik <kristo605@gmail.com>
     Part of the Champions of Anduran project.
  
     This program is free software; you can redistribute it and/or modify
@@ -44,3 +44,30 @@ BOOST_AUTO_TEST_CASE(flat_multimap)
     const int actual[] = {1, 2, 3};
     BOOST_TEST(values == actual, boost::test_tools::per_element());
 }
+
+BOOST_AUTO_TEST_CASE(frozen_multimap)
+{
+    FlatMultimap<int, int> fmm;
+    fmm.insert(3, 7);
+    fmm.insert(0, 5);
+    fmm.insert(3, 6);
+    fmm.insert(0, 5);
+    fmm.freeze();
+    BOOST_TEST(fmm.frozen());
+
+    const auto &cfmm = fmm;
+    const auto range = cfmm.find(3);
+    std::vector values(range.begin(), range.end());
+    const int actual[] = {6, 7};
+    BOOST_TEST(values == actual, boost::test_tools::per_element());
+    BOOST_TEST(cfmm.find(0).size() == 1);
+    BOOST_TEST(cfmm.find(1).empty());  // gap between keys
+    BOOST_TEST(cfmm.find(-1).empty());
+    BOOST_TEST(cfmm.find(4).empty());
+
+    // Inserting more drops back to the unfrozen mode.
+    fmm.insert(1, 2);
+    BOOST_TEST(!fmm.frozen());
+    BOOST_TEST(fmm.find(1).size() == 1);
+    BOOST_TEST(fmm.find(3).size() == 2);
+}
@@ -0,0 +1,49 @@
+/*
+    Copyright (C) 2025 by Michael Kristofik <kristo605@gmail.com>
+    Part of the Champions of Anduran project.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    or at your option any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY.
+
+    See the COPYING.txt file for more details.
+*/
+#include <boost/test/unit_test.hpp>
+
+#include "open-simplex-noise.h"
+
+#include <memory>
+#include <vector>
+
+BOOST_AUTO_TEST_CASE(noise_grid)
+{
+    // Odd sizes and offsets so the last batch of each row is a partial one,
+    // and negative coordinates to exercise rounding down.
+    const int width = 37;
+    const int height = 5;
+    const int x0 = -11;
+    const int y0 = 3;
+    const double featureSize = 2.0;
+
+    for (int seed : {0, 1, 12345}) {
+        osn_context *tmp = nullptr;
+        open_simplex_noise(seed, &tmp);
+        std::shared_ptr<osn_context> ctx(tmp, open_simplex_noise_free);
+
+        std::vector<double> grid(width * height);
+        open_simplex_noise2_grid(ctx.get(), x0, y0, width, height, featureSize,
+                                 grid.data());
+
+        std::vector<double> expected;
+        for (int y = y0; y < y0 + height; ++y) {
+            for (int x = x0; x < x0 + width; ++x) {
+                expected.push_back(open_simplex_noise2(ctx.get(),
+                                                       x / featureSize,
+                                                       y / featureSize));
+            }
+        }
+        BOOST_TEST(grid == expected);
+    }
+}
@@ -1,5 +1,5 @@
 /*
-    Copyright (C) 2020-2024 by Michael Kristofik <kristo605@gmail.com>
+    Copyright (C) 2020-2025 by Michael Kristofik <kristo605@gmail.com>
     Part of the Champions of Anduran project.
 
     This program is free software; you can redistribute it and/or modify
@@ -12,13 +12,24 @@
 */
 #include <boost/test/unit_test.hpp>
 
+#include "ChunkedMapGenerator.h"
 #include "GameState.h"
 #include "ObjectManager.h"
 #include "RandomMap.h"
+#include "fairness_utils.h"
+#include "map_file_format.h"
 BOOST_TEST_DONT_PRINT_LOG_VALUE(ObjectType)
 BOOST_TEST_DONT_PRINT_LOG_VALUE(ObjectAction)
+BOOST_TEST_DONT_PRINT_LOG_VALUE(Terrain)
 
 #include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <queue>
+#include <ranges>
 
 
 BOOST_AUTO_TEST_CASE(names)
@@ -188,3 +199,445 @@ BOOST_AUTO_TEST_CASE(boarding_boat)
     game.update_object(hero);
     BOOST_TEST(game.hex_action(hero, Hex{3, 13}).action == ObjectAction::disembark);
 }
+
+namespace
+{
+    // Regions away from the nearest source, worked out the slow way for
+    // checking RandomMap's distance fields.
+    std::vector<int> region_hops(const RandomMap &rmap, const std::vector<int> &sources)
+    {
+        std::vector<int> hops(rmap.numRegions(), -1);
+        std::queue<int> bfsQ;
+        for (int r : sources) {
+            if (hops[r] < 0) {
+                hops[r] = 0;
+                bfsQ.push(r);
+            }
+        }
+        while (!bfsQ.empty()) {
+            const int region = bfsQ.front();
+            bfsQ.pop();
+            for (int nbr : rmap.getRegionNeighbors(region)) {
+                if (hops[nbr] < 0) {
+                    hops[nbr] = hops[region] + 1;
+                    bfsQ.push(nbr);
+                }
+            }
+        }
+        return hops;
+    }
+}
+
+BOOST_AUTO_TEST_CASE(distance_fields)
+{
+    ObjectManager dummy;
+    RandomMap rmap("tests/map.json", dummy);
+    const auto castles = rmap.getCastleTiles();
+    BOOST_TEST(!castles.empty());
+
+    // With no obstacles in the way, tile distance is hex distance to the
+    // nearest castle.
+    std::vector<int> castleRegions;
+    for (auto &hex : castles) {
+        castleRegions.push_back(rmap.getRegion(rmap.intFromHex(hex)));
+    }
+    const auto castleHops = region_hops(rmap, castleRegions);
+    for (int i = 0; i < rmap.size(); ++i) {
+        const Hex hex = rmap.hexFromInt(i);
+        const int nearest = hexClosestIdx(hex, castles);
+        BOOST_TEST(rmap.tileDistance(ObjectType::castle, i) ==
+                   hexDistance(hex, castles[nearest]));
+        BOOST_TEST(rmap.tileRegionCastleDistance(i) == castleHops[rmap.getRegion(i)]);
+    }
+    for (int r = 0; r < rmap.numRegions(); ++r) {
+        BOOST_TEST(castleHops[r] >= 0);
+        BOOST_TEST(rmap.regionDistance(ObjectType::castle, r) == castleHops[r]);
+    }
+
+    // Multiple sources, including a duplicate.
+    const int first = 0;
+    const int last = rmap.size() - 1;
+    const int sources[] = {first, last, first};
+    const auto field = rmap.tileDistanceField(sources);
+    for (int i = 0; i < rmap.size(); ++i) {
+        const Hex hex = rmap.hexFromInt(i);
+        BOOST_TEST(field[i] == std::min(hexDistance(hex, rmap.hexFromInt(first)),
+                                        hexDistance(hex, rmap.hexFromInt(last))));
+    }
+
+    const std::vector<int> srcRegions = {rmap.getRegion(first),
+                                         rmap.getRegion(last),
+                                         rmap.getRegion(first)};
+    BOOST_TEST(rmap.regionDistanceField(srcRegions) == region_hops(rmap, srcRegions),
+               boost::test_tools::per_element());
+}
+
+BOOST_AUTO_TEST_CASE(object_placement)
+{
+    ObjectManager objs("data/objects.json");
+
+    // Generating a map asserts that each region's pool of free tiles is still
+    // accurate once villages and the other objects are placed.  Here we check
+    // that the pool never hands out the same tile twice, even to different
+    // object types.
+    for (unsigned int seed = 1; seed <= 3; ++seed) {
+        BOOST_TEST_CONTEXT("seed " << seed) {
+            RandomMap rmap(36, seed, objs);
+            std::vector<int> objectTiles;
+            for (auto type : ObjectType()) {
+                for (int tile : rmap.getObjectTiles(type)) {
+                    BOOST_TEST(rmap.getOccupied(tile));
+                    objectTiles.push_back(tile);
+                }
+            }
+            BOOST_TEST(objectTiles.size() > rmap.getCastleTiles().size());
+            std::ranges::sort(objectTiles);
+            BOOST_TEST((std::ranges::adjacent_find(objectTiles) == end(objectTiles)));
+        }
+    }
+}
+
+namespace
+{
+    void check_same_map(RandomMap &lhs, RandomMap &rhs)
+    {
+        BOOST_TEST(lhs.size() == rhs.size());
+        BOOST_TEST(lhs.numRegions() == rhs.numRegions());
+        for (int i = 0; i < rhs.size(); ++i) {
+            BOOST_TEST(lhs.getRegion(i) == rhs.getRegion(i));
+            BOOST_TEST(lhs.getTerrain(i) == rhs.getTerrain(i));
+            BOOST_TEST(lhs.getObstacle(i) == rhs.getObstacle(i));
+            BOOST_TEST(lhs.getOccupied(i) == rhs.getOccupied(i));
+            BOOST_TEST(lhs.getWalkable(i) == rhs.getWalkable(i));
+            BOOST_TEST(lhs.tileRegionCastleDistance(i) == rhs.tileRegionCastleDistance(i));
+            BOOST_TEST(std::ranges::equal(lhs.getTileRegionNeighbors(i),
+                                          rhs.getTileRegionNeighbors(i)));
+        }
+        for (int r = 0; r < rhs.numRegions(); ++r) {
+            BOOST_TEST(std::ranges::equal(lhs.getRegionNeighbors(r),
+                                          rhs.getRegionNeighbors(r)));
+        }
+        for (auto type : ObjectType()) {
+            BOOST_TEST(std::ranges::equal(lhs.getObjectTiles(type),
+                                          rhs.getObjectTiles(type)));
+        }
+        BOOST_TEST(lhs.getCastleTiles() == rhs.getCastleTiles(),
+                   boost::test_tools::per_element());
+    }
+
+    // Every walkable tile in a region can reach every other one without
+    // leaving the region.
+    void check_no_isolated_tiles(RandomMap &rmap)
+    {
+        std::vector<signed char> visited(rmap.size(), 0);
+        std::vector<signed char> regionSeen(rmap.numRegions(), 0);
+        for (int i = 0; i < rmap.size(); ++i) {
+            if (!rmap.getWalkable(i) || visited[i]) {
+                continue;
+            }
+
+            const int region = rmap.getRegion(i);
+            BOOST_TEST(!regionSeen[region]);
+            regionSeen[region] = 1;
+
+            std::vector<int> bfsQ = {i};
+            visited[i] = 1;
+            for (int head = 0; head < ssize(bfsQ); ++head) {
+                for (int nbr : rmap.getTileNeighbors(bfsQ[head])) {
+                    if (!visited[nbr] &&
+                        rmap.getWalkable(nbr) &&
+                        rmap.getRegion(nbr) == region)
+                    {
+                        visited[nbr] = 1;
+                        bfsQ.push_back(nbr);
+                    }
+                }
+            }
+        }
+    }
+
+    std::vector<char> file_contents(const std::filesystem::path &path)
+    {
+        std::ifstream f(path, std::ios::binary);
+        return {std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>()};
+    }
+
+    void write_contents(const std::filesystem::path &path, const std::vector<char> &bytes)
+    {
+        std::ofstream f(path, std::ios::binary);
+        f.write(bytes.data(), ssize(bytes));
+    }
+
+    // Find a section's entry in the table at the start of a binary file (see
+    // binary_utils.h for the layout).  Return its position in the file.
+    size_t section_entry(const std::vector<char> &bytes, uint32_t id)
+    {
+        const size_t headerSize = 16;
+        const size_t entrySize = 24;
+        uint32_t numSections = 0;
+        std::memcpy(&numSections, bytes.data() + 12, sizeof(numSections));
+        for (size_t i = 0; i < numSections; ++i) {
+            const size_t pos = headerSize + i * entrySize;
+            uint32_t entryId = 0;
+            std::memcpy(&entryId, bytes.data() + pos, sizeof(entryId));
+            if (entryId == id) {
+                return pos;
+            }
+        }
+        BOOST_FAIL("section not found");
+        return 0;
+    }
+
+    // Return where a section's data starts.
+    char * section_data(std::vector<char> &bytes, uint32_t id)
+    {
+        uint64_t offset = 0;
+        std::memcpy(&offset, bytes.data() + section_entry(bytes, id) + 8, sizeof(offset));
+        return bytes.data() + offset;
+    }
+
+    // Overwrite one element of an int section.
+    void set_int(std::vector<char> &bytes, uint32_t id, int elem, int value)
+    {
+        std::memcpy(section_data(bytes, id) + elem * sizeof(int), &value, sizeof(value));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(no_isolated_tiles)
+{
+    ObjectManager objs("data/objects.json");
+    RandomMap rmap(72, 5, objs);
+    check_no_isolated_tiles(rmap);
+}
+
+BOOST_AUTO_TEST_CASE(map_file_formats)
+{
+    ObjectManager dummy;
+    RandomMap jsonMap("tests/map.json", dummy);
+    const auto dir = std::filesystem::temp_directory_path();
+
+    const auto binPath = dir / "anduran_test.map";
+    jsonMap.writeBinaryFile(binPath.string().c_str());
+    RandomMap binMap(binPath.string().c_str(), dummy);
+    std::filesystem::remove(binPath);
+    check_same_map(binMap, jsonMap);
+
+    const auto jsonPath = dir / "anduran_test.json";
+    jsonMap.writeFile(jsonPath.string().c_str());
+    RandomMap jsonMap2(jsonPath.string().c_str(), dummy);
+    std::filesystem::remove(jsonPath);
+    check_same_map(jsonMap2, jsonMap);
+}
+
+BOOST_AUTO_TEST_CASE(corrupt_map_files)
+{
+    ObjectManager dummy;
+    RandomMap jsonMap("tests/map.json", dummy);
+    const auto path = std::filesystem::temp_directory_path() / "anduran_corrupt.map";
+    jsonMap.writeBinaryFile(path.string().c_str());
+    const auto good = file_contents(path);
+
+    auto expectThrow = [&path, &dummy] (const std::vector<char> &bytes) {
+        write_contents(path, bytes);
+        BOOST_CHECK_THROW(RandomMap(path.string().c_str(), dummy), std::runtime_error);
+    };
+
+    // Cut short anywhere.
+    for (size_t size : {size_t{20}, good.size() / 2, good.size() - 1}) {
+        expectThrow({begin(good), begin(good) + size});
+    }
+
+    // A section count big enough to wrap around when multiplied by the
+    // element size.
+    auto bytes = good;
+    const uint64_t hugeCount = uint64_t{1} << 62;
+    std::memcpy(bytes.data() + section_entry(bytes, MapFile::tileRegions) + 16,
+                &hugeCount, sizeof(hugeCount));
+    expectThrow(bytes);
+
+    // Missing section.
+    bytes = good;
+    const uint32_t unknownId = 999;
+    std::memcpy(bytes.data() + section_entry(bytes, MapFile::tileWalkable),
+                &unknownId, sizeof(unknownId));
+    expectThrow(bytes);
+
+    // Values out of range.
+    const int tooBig = jsonMap.size() + 1000;
+    const std::pair<MapFile::Section, int> badValues[] = {
+        {MapFile::tileRegions, tooBig},
+        {MapFile::tileRegions, -1},
+        {MapFile::regionTerrain, 1000},
+        {MapFile::castles, tooBig},
+        {MapFile::regionCastleDistance, tooBig},
+        {MapFile::objectOffsets, tooBig},
+        {MapFile::tileRegionNeighbors, tooBig},
+        {MapFile::regionNeighbors, -5}
+    };
+    for (auto [id, value] : badValues) {
+        bytes = good;
+        set_int(bytes, id, 0, value);
+        expectThrow(bytes);
+    }
+
+    // Object offsets going backwards, multimap out of order.
+    bytes = good;
+    set_int(bytes, MapFile::objectOffsets, 1, 5);
+    set_int(bytes, MapFile::objectOffsets, 2, 4);
+    expectThrow(bytes);
+    bytes = good;
+    set_int(bytes, MapFile::regionNeighbors, 2, 0);
+    set_int(bytes, MapFile::regionNeighbors, 3, 0);
+    expectThrow(bytes);
+
+    // Make sure it was the damage that caused all that.
+    write_contents(path, good);
+    BOOST_CHECK_NO_THROW(RandomMap(path.string().c_str(), dummy));
+    std::filesystem::remove(path);
+}
+
+BOOST_AUTO_TEST_CASE(map_checkpoints)
+{
+    ObjectManager objs("data/objects.json");
+    const auto dir = std::filesystem::temp_directory_path();
+    const auto ckptPath = (dir / "anduran_test.ckpt").string();
+
+    RandomMap fullMap(36, 99, objs, 1,
+        [&ckptPath] (RandomMap &map, MapStage stage) {
+            if (stage == MapStage::castles) {
+                map.writeCheckpoint(ckptPath.c_str());
+            }
+        });
+
+    // Resuming with the original seed picks up the random number stream where
+    // it left off, so we get the same map.
+    auto resumed = RandomMap::resume(ckptPath.c_str(), objs);
+    BOOST_TEST(resumed.seed() == fullMap.seed());
+    check_same_map(resumed, fullMap);
+
+    // Rerolling keeps the terrain and castles but moves the objects.
+    auto rerolled = RandomMap::resume(ckptPath.c_str(), objs, 12345);
+    std::filesystem::remove(ckptPath);
+    for (int i = 0; i < fullMap.size(); ++i) {
+        BOOST_TEST(rerolled.getRegion(i) == fullMap.getRegion(i));
+        BOOST_TEST(rerolled.getTerrain(i) == fullMap.getTerrain(i));
+    }
+    BOOST_TEST(rerolled.getCastleTiles() == fullMap.getCastleTiles(),
+               boost::test_tools::per_element());
+    BOOST_TEST(!std::ranges::equal(rerolled.getObjectTiles(ObjectType::army),
+                                   fullMap.getObjectTiles(ObjectType::army)));
+
+    // A finished map has nothing left to resume.
+    BOOST_CHECK_THROW(fullMap.writeCheckpoint(ckptPath.c_str()), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(corrupt_checkpoints)
+{
+    ObjectManager objs("data/objects.json");
+    const auto path = (std::filesystem::temp_directory_path() / "anduran_corrupt.ckpt").string();
+    RandomMap fullMap(36, 99, objs, 1,
+        [&path] (RandomMap &map, MapStage stage) {
+            if (stage == MapStage::castles) {
+                map.writeCheckpoint(path.c_str());
+            }
+        });
+    const auto good = file_contents(path);
+
+    auto expectThrow = [&path, &objs] (const std::vector<char> &bytes) {
+        write_contents(path, bytes);
+        BOOST_CHECK_THROW(RandomMap::resume(path.c_str(), objs), std::runtime_error);
+    };
+
+    expectThrow({begin(good), begin(good) + good.size() / 2});
+
+    auto bytes = good;
+    std::memcpy(section_data(bytes, MapFile::randomState), "junk", 4);
+    expectThrow(bytes);
+
+    bytes = good;
+    const uint32_t unknownId = 999;
+    std::memcpy(bytes.data() + section_entry(bytes, MapFile::regionLandmass),
+                &unknownId, sizeof(unknownId));
+    expectThrow(bytes);
+
+    const int tooBig = fullMap.size() + 1000;
+    const std::pair<MapFile::Section, int> badValues[] = {
+        {MapFile::tileRegions, -1},
+        {MapFile::regionTerrain, -1},
+        {MapFile::borderTiles, tooBig},
+        {MapFile::tileRegionNeighbors, tooBig},
+        {MapFile::castles, tooBig},
+        {MapFile::regionCastleDistance, tooBig},
+        {MapFile::coastTileOffsets, 1}
+    };
+    for (auto [id, value] : badValues) {
+        bytes = good;
+        set_int(bytes, id, 0, value);
+        expectThrow(bytes);
+    }
+
+    write_contents(path, good);
+    BOOST_CHECK_NO_THROW(RandomMap::resume(path.c_str(), objs));
+    std::filesystem::remove(path);
+}
+
+BOOST_AUTO_TEST_CASE(chunked_map_generation)
+{
+    const auto dir = std::filesystem::temp_directory_path();
+    const auto smallBands = dir / "anduran_test_small.map";
+    const auto oneBand = dir / "anduran_test_one.map";
+    const auto jsonPath = dir / "anduran_test_chunked.json";
+
+    // The band size doesn't change the map.  Bands see 66 extra rows on either
+    // side, so the map has to be several times that tall for the bands in the
+    // middle to be cut off at both ends.
+    ChunkedMapGenerator smallGen(256, 7, 16);
+    ChunkedMapGenerator oneGen(256, 7, 256);
+    BOOST_TEST(smallGen.bandRows() == 16);
+    BOOST_TEST(oneGen.bandRows() == oneGen.width());
+    smallGen.writeBinaryFile(smallBands.string().c_str());
+    oneGen.writeBinaryFile(oneBand.string().c_str());
+    oneGen.writeJsonFile(jsonPath.string().c_str());
+    BOOST_TEST((file_contents(smallBands) == file_contents(oneBand)));
+
+    ObjectManager dummy;
+    RandomMap binMap(smallBands.string().c_str(), dummy);
+    RandomMap jsonMap(jsonPath.string().c_str(), dummy);
+    std::filesystem::remove(smallBands);
+    std::filesystem::remove(oneBand);
+    std::filesystem::remove(jsonPath);
+
+    BOOST_TEST(binMap.width() == 256);
+    BOOST_TEST(binMap.numRegions() == smallGen.numRegions());
+    BOOST_TEST(ssize(binMap.getCastleTiles()) == 4);
+    check_no_isolated_tiles(binMap);
+    check_same_map(binMap, jsonMap);
+}
+
+BOOST_AUTO_TEST_CASE(map_fairness_search)
+{
+    ObjectManager dummy;
+    RandomMap rmap("tests/map.json", dummy);
+    const auto fairness = map_fairness(rmap);
+    BOOST_TEST(ssize(fairness.castles) == ssize(rmap.getCastleTiles()));
+    BOOST_TEST(fairness.score >= 0.0);
+    for (auto &c : fairness.castles) {
+        BOOST_TEST(c.rivalDistance > 0);
+    }
+
+    // Same winner no matter how many threads did the work.
+    ObjectManager objs("data/objects.json");
+    const auto serial = fairest_map(36, 99, 4, objs, 1);
+    const auto parallel = fairest_map(36, 99, 4, objs, 3);
+    BOOST_TEST(serial.best == parallel.best);
+    BOOST_TEST(serial.map.seed() == serial.candidates[serial.best].seed);
+    BOOST_TEST(parallel.map.seed() == serial.map.seed());
+    for (auto &c : serial.candidates) {
+        BOOST_TEST(serial.candidates[serial.best].score <= c.score);
+    }
+
+    // Maps too small to place castles on fail the same way whether or not the
+    // candidates are generated on other threads.
+    BOOST_CHECK_THROW(fairest_map(8, 99, 4, objs, 1), std::runtime_error);
+    BOOST_CHECK_THROW(fairest_map(8, 99, 4, objs, 3), std::runtime_error);
+}
@@ -0,0 +1,406 @@
+/*
+    Copyright (C) 2025 by Michael Kristofik <kristo605@gmail.com>
+    Part of the Champions of Anduran project.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    or at your option any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY.
+
+    See the COPYING.txt file for more details.
+*/
+#include <boost/mpl/list.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include "GameState.h"
+#include "ObjectManager.h"
+#include "Pathfinder.h"
+#include "PriorityQueue.h"
+#include "RandomMap.h"
+#include "RoutePlanner.h"
+BOOST_TEST_DONT_PRINT_LOG_VALUE(ObjectAction)
+
+#include <algorithm>
+#include <vector>
+
+namespace
+{
+    // Walking distance from 'src' to every tile a champion could reach this
+    // turn without any objects in the way: same region, same kind of terrain.
+    std::vector<int> region_distances(const RandomMap &rmap, int src)
+    {
+        const int region = rmap.getRegion(src);
+        const bool onWater = rmap.getTerrain(src) == Terrain::water;
+        std::vector<int> dist(rmap.size(), -1);
+        std::vector<int> bfsQ = {src};
+        dist[src] = 0;
+        for (int head = 0; head < ssize(bfsQ); ++head) {
+            for (int nbr : rmap.getTileNeighbors(bfsQ[head])) {
+                if (dist[nbr] < 0 &&
+                    rmap.getWalkable(nbr) &&
+                    rmap.getRegion(nbr) == region &&
+                    (rmap.getTerrain(nbr) == Terrain::water) == onWater)
+                {
+                    dist[nbr] = dist[bfsQ[head]] + 1;
+                    bfsQ.push_back(nbr);
+                }
+            }
+        }
+        return dist;
+    }
+
+    // Walking distance from 'src' to every land tile, going around anything the
+    // map generator put in the way.  Tiles next to one we can walk to are
+    // reachable too, since a route can end on an object.
+    std::vector<int> open_distances(const RandomMap &rmap, int src)
+    {
+        std::vector<int> dist(rmap.size(), -1);
+        std::vector<int> bfsQ = {src};
+        dist[src] = 0;
+        for (int head = 0; head < ssize(bfsQ); ++head) {
+            const int tile = bfsQ[head];
+            if (tile != src && rmap.getOccupied(tile)) {
+                continue;
+            }
+            for (int nbr : rmap.getTileNeighbors(tile)) {
+                if (dist[nbr] < 0 &&
+                    rmap.getWalkable(nbr) &&
+                    rmap.getTerrain(nbr) != Terrain::water)
+                {
+                    dist[nbr] = dist[tile] + 1;
+                    bfsQ.push_back(nbr);
+                }
+            }
+        }
+        return dist;
+    }
+
+    // Put a champion on the first walkable land tile.
+    GameObject add_hero(const RandomMap &rmap, GameState &game)
+    {
+        int src = 0;
+        while (!rmap.getWalkable(src) || rmap.getTerrain(src) == Terrain::water) {
+            ++src;
+        }
+        GameObject hero;
+        hero.hex = rmap.hexFromInt(src);
+        hero.entity = 1;
+        hero.type = ObjectType::champion;
+        game.add_object(hero);
+        return hero;
+    }
+
+    // Every step of the path has to be to an adjacent tile.
+    bool is_connected(const Path &path)
+    {
+        return std::ranges::adjacent_find(path, [] (const Hex &a, const Hex &b) {
+            return hexDistance(a, b) != 1;
+        }) == std::end(path);
+    }
+}
+
+
+// Same answers no matter which priority queue the search uses.
+using PathfinderTypes = boost::mpl::list<Pathfinder, HeapPathfinder>;
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(shortest_paths, PathfinderType, PathfinderTypes)
+{
+    ObjectManager dummy;
+    RandomMap rmap("tests/map.json", dummy);
+    GameState game(rmap);
+    PathfinderType pathfind(rmap, game);
+
+    // Start from the first walkable land tile.
+    const auto hero = add_hero(rmap, game);
+    const int src = rmap.intFromHex(hero.hex);
+
+    // Paths to every tile in the region are as short as possible.  Reusing the
+    // same Pathfinder for each one shouldn't leave anything behind from the
+    // searches before it.
+    const auto dist = region_distances(rmap, src);
+    int numPaths = 0;
+    for (int i = 0; i < rmap.size(); ++i) {
+        if (i == src || dist[i] < 0) {
+            continue;
+        }
+        const auto path = pathfind.find_path(hero, rmap.hexFromInt(i));
+        BOOST_TEST_REQUIRE(!path.empty());
+        BOOST_TEST(path.front() == hero.hex);
+        BOOST_TEST(path.back() == rmap.hexFromInt(i));
+        BOOST_TEST(ssize(path) - 1 == dist[i]);
+        BOOST_TEST(is_connected(path));
+        ++numPaths;
+    }
+    BOOST_TEST(numPaths > 10);
+
+    // No path to an obstacle, or to where we already are.
+    int obstacle = 0;
+    while (rmap.getWalkable(obstacle)) {
+        ++obstacle;
+    }
+    BOOST_TEST(pathfind.find_path(hero, rmap.hexFromInt(obstacle)).empty());
+    BOOST_TEST(pathfind.find_path(hero, hero.hex).empty());
+}
+
+BOOST_AUTO_TEST_CASE(reachable_tiles)
+{
+    ObjectManager dummy;
+    RandomMap rmap("tests/map.json", dummy);
+    GameState game(rmap);
+    Pathfinder pathfind(rmap, game);
+    Pathfinder flood(rmap, game);
+
+    const auto hero = add_hero(rmap, game);
+    const int src = rmap.intFromHex(hero.hex);
+
+    // Put an army in the hero's way.
+    const auto dist = region_distances(rmap, src);
+    const int iArmy = std::ranges::find(dist, 4) - std::begin(dist);
+    BOOST_TEST_REQUIRE(iArmy < rmap.size());
+    GameObject army;
+    army.hex = rmap.hexFromInt(iArmy);
+    army.entity = 2;
+    army.type = ObjectType::army;
+    game.add_object(army);
+
+    // With every step costing the same and movement to spare, the flood agrees
+    // with A* about where the hero can go and how far it is.
+    const EnumSizedArray<int, Terrain> sameCost = {1, 1, 1, 1, 1, 1};
+    flood.find_reachable(hero, rmap.size(), sameCost);
+    int numReachable = 0;
+    for (int i = 0; i < rmap.size(); ++i) {
+        const auto hex = rmap.hexFromInt(i);
+        const auto path = flood.reachable_path(hex);
+        BOOST_TEST(ssize(path) == ssize(pathfind.find_path(hero, hex)));
+        BOOST_TEST(flood.reachable_cost(hex) == std::max<int>(ssize(path) - 1, -1));
+        if (!path.empty()) {
+            BOOST_TEST(path.front() == hero.hex);
+            BOOST_TEST(path.back() == hex);
+            BOOST_TEST(is_connected(path));
+            ++numReachable;
+        }
+    }
+    BOOST_TEST(numReachable == ssize(flood.reachable_tiles()));
+    BOOST_TEST(flood.reachable_cost(army.hex) == 4);
+
+    // Limited movement cuts off the far tiles.
+    flood.find_reachable(hero, 2, sameCost);
+    for (int i : flood.reachable_tiles()) {
+        BOOST_TEST(flood.reachable_cost(rmap.hexFromInt(i)) <= 2);
+    }
+    BOOST_TEST(flood.reachable_cost(army.hex) == -1);
+
+    // Changing the game state starts a new flood.
+    game.remove_object(army.entity);
+    flood.find_reachable(hero, rmap.size(), sameCost);
+    BOOST_TEST(ssize(flood.reachable_tiles()) >= numReachable);
+    BOOST_TEST(flood.reachable_cost(army.hex) == 4);
+    BOOST_TEST(flood.reachable_path(army.hex).size() == 5u);
+}
+
+BOOST_AUTO_TEST_CASE(cached_tile_actions)
+{
+    ObjectManager objConfig;
+    MapObject obj;
+    obj.type = ObjectType::obelisk;
+    obj.action = ObjectAction::visit;
+    objConfig.insert(obj);
+
+    RandomMap rmap("tests/map.json", objConfig);
+    GameState game(rmap);
+    Pathfinder pathfind(rmap, game);
+    const auto hero = add_hero(rmap, game);
+    const int src = rmap.intFromHex(hero.hex);
+
+    const auto dist = region_distances(rmap, src);
+    const int iDest = std::ranges::find(dist, 8) - std::begin(dist);
+    BOOST_TEST_REQUIRE(iDest < rmap.size());
+    const auto hDest = rmap.hexFromInt(iDest);
+    const auto path = pathfind.find_path(hero, hDest);
+    BOOST_TEST_REQUIRE(ssize(path) == 9);
+
+    // Adding, moving, or removing an army changes the game state version, so
+    // the next search sees it.
+    auto isBattle = [&] (const Hex &hex) {
+        return game.hex_action(hero, hex).action == ObjectAction::battle;
+    };
+    GameObject army;
+    army.hex = path[4];
+    army.entity = 2;
+    army.type = ObjectType::army;
+    game.add_object(army);
+    auto detour = pathfind.find_path(hero, hDest);
+    BOOST_TEST((detour != path));
+    BOOST_TEST(std::ranges::none_of(detour, isBattle));
+
+    army.hex = rmap.hexFromInt(rmap.size() - 1);
+    BOOST_TEST_REQUIRE(hexDistance(army.hex, hero.hex) > 20);
+    game.update_object(army);
+    BOOST_TEST(pathfind.find_path(hero, hDest) == path, boost::test_tools::per_element());
+
+    army.hex = path[4];
+    game.update_object(army);
+    detour = pathfind.find_path(hero, hDest);
+    BOOST_TEST((detour != path));
+    BOOST_TEST(std::ranges::none_of(detour, isBattle));
+
+    game.remove_object(army.entity);
+    BOOST_TEST(pathfind.find_path(hero, hDest) == path, boost::test_tools::per_element());
+
+    // Surround the hero with obelisks red has already visited.  They're in
+    // the way of anyone else, but red walks right past them.
+    int entity = 10;
+    for (const auto &hex : hero.hex.getAllNeighbors()) {
+        if (rmap.offGrid(hex)) {
+            continue;
+        }
+        GameObject obelisk;
+        obelisk.hex = hex;
+        obelisk.entity = entity++;
+        obelisk.type = ObjectType::obelisk;
+        obelisk.visited.set(Team::red);
+        game.add_object(obelisk);
+    }
+    auto redHero = hero;
+    redHero.team = Team::red;
+    BOOST_TEST(pathfind.find_path(hero, hDest).empty());
+    BOOST_TEST(ssize(pathfind.find_path(redHero, hDest)) == ssize(path));
+    BOOST_TEST(pathfind.find_path(hero, hDest).empty());
+
+    // Stepping onto land from a boat is a different action than walking there.
+    int iWater = -1;
+    int iLand = -1;
+    int iShore = -1;
+    for (int i = 0; i < rmap.size() && iShore < 0; ++i) {
+        if (rmap.getTerrain(i) != Terrain::water || !rmap.getWalkable(i)) {
+            continue;
+        }
+        for (int land : rmap.getTileNeighbors(i)) {
+            if (rmap.getTerrain(land) == Terrain::water || !rmap.getWalkable(land)) {
+                continue;
+            }
+            for (int shore : rmap.getTileNeighbors(land)) {
+                if (rmap.getTerrain(shore) != Terrain::water &&
+                    rmap.getWalkable(shore) &&
+                    rmap.getRegion(shore) == rmap.getRegion(land))
+                {
+                    iWater = i;
+                    iLand = land;
+                    iShore = shore;
+                    break;
+                }
+            }
+            if (iShore >= 0) {
+                break;
+            }
+        }
+    }
+    BOOST_TEST_REQUIRE(iShore >= 0);
+    BOOST_TEST_REQUIRE(game.objects_in_hex(rmap.hexFromInt(iLand)).empty());
+
+    auto sailor = hero;
+    sailor.hex = rmap.hexFromInt(iShore);
+    const auto hLand = rmap.hexFromInt(iLand);
+    BOOST_TEST(ssize(pathfind.find_path(sailor, hLand)) == 2);
+    sailor.hex = rmap.hexFromInt(iWater);
+    BOOST_TEST(game.hex_action(sailor, hLand).action == ObjectAction::disembark);
+    const auto landing = pathfind.find_path(sailor, hLand);
+    BOOST_TEST_REQUIRE(ssize(landing) == 2);
+    BOOST_TEST(landing.back() == hLand);
+}
+
+BOOST_AUTO_TEST_CASE(routes)
+{
+    ObjectManager dummy;
+    RandomMap rmap("tests/map.json", dummy);
+    GameState game(rmap);
+    RoutePlanner planner(rmap, game);
+    BOOST_TEST(planner.num_portals() > 0);
+
+    const auto hero = add_hero(rmap, game);
+    const int src = rmap.intFromHex(hero.hex);
+
+    // Anywhere you can walk to has a route, across as many regions as it
+    // takes.  Routes have to go through the middle of each border, so they
+    // can be a little longer than the shortest walk.  There are no objects in
+    // the game state, so they're allowed to cut across occupied tiles.
+    const auto dist = open_distances(rmap, src);
+    const std::vector<int> srcTiles = {src};
+    const auto shortest = rmap.walkingDistanceField(srcTiles);
+    int numRoutes = 0;
+    int totalSteps = 0;
+    int totalDist = 0;
+    for (int i = 0; i < rmap.size(); ++i) {
+        if (i == src || !rmap.getWalkable(i) || rmap.getTerrain(i) == Terrain::water) {
+            continue;
+        }
+
+        const auto route = planner.find_route(hero, rmap.hexFromInt(i));
+        if (dist[i] < 0) {
+            continue;
+        }
+        BOOST_TEST_REQUIRE(!route.empty());
+        BOOST_TEST(route.front() == hero.hex);
+        BOOST_TEST(route.back() == rmap.hexFromInt(i));
+        BOOST_TEST(is_connected(route));
+        BOOST_TEST(ssize(route) - 1 >= shortest[i]);
+        BOOST_TEST(std::ranges::all_of(route, [&rmap] (const Hex &hex) {
+            return rmap.getWalkable(hex) && rmap.getTerrain(hex) != Terrain::water;
+        }));
+        ++numRoutes;
+        totalSteps += ssize(route) - 1;
+        totalDist += shortest[i];
+    }
+    BOOST_TEST(numRoutes > 100);
+    BOOST_TEST(totalSteps < totalDist * 1.25);
+}
+
+BOOST_AUTO_TEST_CASE(priority_queues)
+{
+    struct Elem
+    {
+        int cost = 0;
+        int id = 0;
+
+        bool operator>(const Elem &rhs) const { return cost > rhs.cost; }
+    };
+
+    // Interleave pushes and pops the way A* does, never pushing anything
+    // cheaper than the last thing popped.
+    PriorityQueue<Elem> lazy;
+    BinaryHeap<Elem> heap;
+    BucketQueue<Elem> buckets;
+    int lastCost = 0;
+    int nextId = 0;
+    for (int round = 0; round < 50; ++round) {
+        for (int offset : {2, 0, 1}) {
+            const Elem elem = {lastCost + offset, nextId++};
+            lazy.push(elem);
+            heap.push(elem);
+            buckets.push(elem);
+        }
+        const int cost = lazy.pop().cost;
+        BOOST_TEST(heap.pop().cost == cost);
+        BOOST_TEST(buckets.pop().cost == cost);
+        BOOST_TEST(cost >= lastCost);
+        lastCost = cost;
+    }
+
+    while (!lazy.empty()) {
+        const int cost = lazy.pop().cost;
+        BOOST_TEST(heap.pop().cost == cost);
+        BOOST_TEST(buckets.pop().cost == cost);
+    }
+    BOOST_TEST(heap.empty());
+    BOOST_TEST(buckets.empty());
+
+    // Clearing starts over from the lowest priority.
+    buckets.push({5, 0});
+    buckets.pop();
+    buckets.push({7, 0});
+    buckets.clear();
+    BOOST_TEST(buckets.empty());
+    buckets.push({1, 1});
+    BOOST_TEST(buckets.pop().id == 1);
+}
@@ -1,5 +1,5 @@
 /*
-    Copyright (C) 2021 by Michael Kristofik <kristo605@gmail.com>
+    Copyright (C) 2021-2025 by Michael Kristofik <kristo605@gmail.com>
     Part of the Champions of Anduran project.
  
     This program is free software; you can redistribute it and/or modify
@@ -14,6 +14,21 @@
 
 #include "RandomRange.h"
 #include <iostream>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    std::vector<int> roll_dice(int count)
+    {
+        RandomRange dice(1, 6);
+        std::vector<int> rolls;
+        for (int i = 0; i < count; ++i) {
+            rolls.push_back(dice.get());
+        }
+        return rolls;
+    }
+}
 
 BOOST_AUTO_TEST_CASE(random_numbers)
 {
@@ -27,3 +42,46 @@ BOOST_AUTO_TEST_CASE(random_numbers)
     }
     std::cout << '\n';
 }
+
+BOOST_AUTO_TEST_CASE(repeatable_seeds)
+{
+    std::vector<int> first;
+    std::vector<int> second;
+    {
+        ScopedRandomSeed seed(42);
+        first = roll_dice(20);
+    }
+    {
+        ScopedRandomSeed seed(42);
+        second = roll_dice(20);
+    }
+    BOOST_TEST(first == second);
+
+    // A seeded block doesn't disturb the sequence we were already on: the next
+    // numbers are the ones we'd have gotten without it.
+    const auto before = RandomRange::engine;
+    {
+        ScopedRandomSeed seed(99);
+        roll_dice(20);
+    }
+    const auto after = roll_dice(20);
+    RandomRange::engine = before;
+    BOOST_TEST(after == roll_dice(20));
+
+    BOOST_TEST(RandomRange::split_seed(42, 0) == RandomRange::split_seed(42, 0));
+    BOOST_TEST(RandomRange::split_seed(42, 0) != RandomRange::split_seed(42, 1));
+    BOOST_TEST(RandomRange::split_seed(42, 0) != RandomRange::split_seed(43, 0));
+}
+
+BOOST_AUTO_TEST_CASE(thread_local_engines)
+{
+    // Two threads with the same seed produce the same numbers, without
+    // interfering with each other.
+    std::vector<int> rolls1;
+    std::vector<int> rolls2;
+    {
+        std::jthread t1([&rolls1] { RandomRange::seed(7); rolls1 = roll_dice(1000); });
+        std::jthread t2([&rolls2] { RandomRange::seed(7); rolls2 = roll_dice(1000); });
+    }
+    BOOST_TEST(rolls1 == rolls2);
+}
@@ -0,0 +1,68 @@
+/*
+    Copyright (C) 2025 by Michael Kristofik <kristo605@gmail.com>
+    Part of the Champions of Anduran project.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    or at your option any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY.
+
+    See the COPYING.txt file for more details.
+*/
+#include <boost/test/unit_test.hpp>
+
+#include "thread_utils.h"
+
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+BOOST_AUTO_TEST_CASE(parallel_loops)
+{
+    std::vector<int> visits(100, 0);
+    parallel_blocks(ssize(visits), 3, [&visits] (int first, int last, int) {
+        for (int i = first; i < last; ++i) {
+            ++visits[i];
+        }
+    });
+    BOOST_TEST(std::ranges::count(visits, 1) == ssize(visits));
+
+    std::vector<std::atomic<int>> taskVisits(100);
+    parallel_tasks(ssize(taskVisits), 3, [&taskVisits] (int i) { ++taskVisits[i]; });
+    for (auto &v : taskVisits) {
+        BOOST_TEST(v == 1);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(worker_exceptions)
+{
+    // Throwing on a worker thread reaches the caller instead of terminating.
+    std::vector<int> finished(3, 0);
+    auto throwFromBlock = [&finished] (int, int, int block) {
+        if (block == 2) {
+            throw std::runtime_error("block failed");
+        }
+        finished[block] = 1;
+    };
+    BOOST_CHECK_THROW(parallel_blocks(30, 3, throwFromBlock), std::runtime_error);
+    BOOST_TEST(finished[0] == 1);
+    BOOST_TEST(finished[1] == 1);
+
+    // The calling thread's own block too.
+    BOOST_CHECK_THROW(parallel_blocks(30, 3, [] (int, int, int block) {
+        if (block == 0) {
+            throw std::runtime_error("block failed");
+        }
+    }), std::runtime_error);
+
+    // Same for tasks, including when running single threaded.
+    for (int numThreads : {1, 4}) {
+        BOOST_CHECK_THROW(parallel_tasks(20, numThreads, [] (int i) {
+            if (i == 7) {
+                throw std::runtime_error("task failed");
+            }
+        }), std::runtime_error);
+    }
+}